@@ -0,0 +1,48 @@
+#include "Benchmark.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Global operator new/delete replaced to count heap allocations. The engine
+// is a static library linked into this executable, so its allocations are
+// counted too. Aligned allocations go through the default implementation and
+// aren't counted.
+
+namespace
+{
+
+std::atomic<uint64_t> allocations{0};
+std::atomic<uint64_t> allocatedBytes{0};
+
+void* countedAlloc(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+} // namespace
+
+namespace bench
+{
+
+AllocationCounts allocationCounts()
+{
+    return AllocationCounts{
+        allocations.load(std::memory_order_relaxed),
+        allocatedBytes.load(std::memory_order_relaxed)};
+}
+
+} // namespace bench
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
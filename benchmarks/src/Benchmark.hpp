@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Set by CMake to the commit being measured
+#ifndef BENCH_REVISION
+    #define BENCH_REVISION "unknown"
+#endif
+
+namespace bench
+{
+
+// Keeps the optimizer from dropping work whose result is otherwise unused
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+    const volatile T sink = value;
+    (void)sink;
+}
+
+// Runs fn(iterations) and returns how many iterations per second it managed
+template<typename F>
+double measureRate(uint64_t iterations, F&& fn)
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Warm up caches and branch predictors before timing
+    fn(iterations / 10);
+
+    const auto start = Clock::now();
+    fn(iterations);
+    const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    return static_cast<double>(iterations) / elapsed.count();
+}
+
+inline void report(const char* name, double rate, const char* unit)
+{
+    std::printf("  %-40s %14.0f %s/s\n", name, rate, unit);
+}
+
+// Heap allocations made through operator new since the process started
+struct AllocationCounts
+{
+    uint64_t allocations;
+    uint64_t bytes;
+};
+AllocationCounts allocationCounts();
+
+void runEventDispatch();
+// Imports a generated million triangle OBJ file on one thread and on all of
+// them
+void runImport();
+// Renders every scene headless for frames frames and writes the results to
+// jsonPath. Returns false if the file couldn't be written.
+bool runRender(uint32_t frames, const char* jsonPath);
+// Renders every scene headless for frames frames and compares the last one
+// with directory/<scene>.ppm, writing <scene>.actual.ppm and <scene>.diff.ppm
+// next to it on a mismatch, and warns when directory/DRIVER names another
+// device. With update the references and DRIVER are rewritten instead.
+// Returns how many scenes failed.
+uint32_t runGolden(const char* directory, uint32_t frames, uint32_t tolerance, bool update);
+
+} // namespace bench
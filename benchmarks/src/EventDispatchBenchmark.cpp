@@ -0,0 +1,167 @@
+#include "Benchmark.hpp"
+
+#include <functional>
+
+#include "Events/ApplicationEvent.hpp"
+#include "Events/EventHandlerTable.hpp"
+#include "Events/EventQueue.hpp"
+#include "Events/KeyEvent.hpp"
+#include "Events/MouseEvent.hpp"
+
+namespace bench
+{
+
+using namespace ember;
+
+namespace
+{
+
+constexpr uint64_t EVENT_COUNT = 20'000'000;
+
+// The dispatcher Application::OnEvent used before the handler table, kept
+// here as the baseline
+class LegacyEventDispatcher
+{
+    template<typename T>
+    using EventFn = std::function<bool(T&)>;
+
+public:
+    LegacyEventDispatcher(Event& event)
+        : event_(event) {}
+
+    template<typename T>
+    bool Dispatch(EventFn<T> func)
+    {
+        if (event_.GetEventType() == T::GetStaticType()) {
+            func(*(T*)&event_);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    Event& event_;
+};
+
+#define BIND_EVENT_FN(x) std::bind(&x, this, std::placeholders::_1)
+
+// Stand-in for Application with the same set of virtual handlers
+class Listener
+{
+public:
+    Listener()
+    {
+        table.Register<WindowCloseEvent, Listener, &Listener::OnWindowClose>(this);
+        table.Register<WindowResizeEvent, Listener, &Listener::OnWindowResize>(this);
+        table.Register<KeyPressedEvent, Listener, &Listener::OnKeyPressed>(this);
+        table.Register<KeyRepeatEvent, Listener, &Listener::OnKeyRepeat>(this);
+        table.Register<KeyReleasedEvent, Listener, &Listener::OnKeyReleased>(this);
+        table.Register<MouseButtonPressedEvent, Listener, &Listener::OnMouseButtonPressed>(this);
+        table.Register<MouseButtonReleasedEvent, Listener, &Listener::OnMouseButtonReleased>(this);
+        table.Register<MouseMovedEvent, Listener, &Listener::OnMouseMoved>(this);
+        table.Register<MouseScrolledEvent, Listener, &Listener::OnMouseScrolled>(this);
+    }
+    virtual ~Listener() = default;
+
+    void OnEventLegacy(Event& e)
+    {
+        LegacyEventDispatcher dispatcher(e);
+        dispatcher.Dispatch<WindowCloseEvent>(BIND_EVENT_FN(Listener::OnWindowClose));
+        dispatcher.Dispatch<WindowResizeEvent>(BIND_EVENT_FN(Listener::OnWindowResize));
+        dispatcher.Dispatch<KeyPressedEvent>(BIND_EVENT_FN(Listener::OnKeyPressed));
+        dispatcher.Dispatch<KeyRepeatEvent>(BIND_EVENT_FN(Listener::OnKeyRepeat));
+        dispatcher.Dispatch<KeyReleasedEvent>(BIND_EVENT_FN(Listener::OnKeyReleased));
+        dispatcher.Dispatch<MouseButtonPressedEvent>(BIND_EVENT_FN(Listener::OnMouseButtonPressed));
+        dispatcher.Dispatch<MouseButtonReleasedEvent>(BIND_EVENT_FN(Listener::OnMouseButtonReleased));
+        dispatcher.Dispatch<MouseMovedEvent>(BIND_EVENT_FN(Listener::OnMouseMoved));
+        dispatcher.Dispatch<MouseScrolledEvent>(BIND_EVENT_FN(Listener::OnMouseScrolled));
+    }
+
+    virtual bool OnWindowClose(WindowCloseEvent&) { handled++; return false; }
+    virtual bool OnWindowResize(WindowResizeEvent& e) { handled += e.GetWidth() != 0; return false; }
+    virtual bool OnKeyPressed(KeyPressedEvent&) { handled++; return false; }
+    virtual bool OnKeyRepeat(KeyRepeatEvent&) { handled++; return false; }
+    virtual bool OnKeyReleased(KeyReleasedEvent&) { handled++; return false; }
+    virtual bool OnMouseButtonPressed(MouseButtonPressedEvent&) { handled++; return false; }
+    virtual bool OnMouseButtonReleased(MouseButtonReleasedEvent&) { handled++; return false; }
+    virtual bool OnMouseMoved(MouseMovedEvent& e) { handled += e.GetX() >= 0.0f; return false; }
+    virtual bool OnMouseScrolled(MouseScrolledEvent&) { handled++; return false; }
+
+    EventHandlerTable table;
+    uint64_t handled = 0;
+};
+
+// Mixed stream roughly shaped like real input: mostly mouse motion
+QueuedEvent mixedEvent(uint64_t i)
+{
+    switch (i & 7) {
+        case 0: return QueuedEvent::Key(EventType::KeyPressed, KeyCode::A);
+        case 1: return QueuedEvent::Key(EventType::KeyReleased, KeyCode::A);
+        case 2: return QueuedEvent::Mouse(EventType::MouseScrolled, 0.0f, 1.0f);
+        case 3: return QueuedEvent::MouseButton(EventType::MouseButtonPressed, 0);
+        default: return QueuedEvent::Mouse(EventType::MouseMoved, static_cast<float>(i & 1023), 1.0f);
+    }
+}
+
+// Pushes events through a queue in frame sized batches and drains each one
+template<typename F>
+void drainMixed(uint64_t n, F&& handler)
+{
+    // Measure dispatch of every event, not how many get merged
+    EventQueue queue;
+    queue.SetCoalescing(false);
+    for (uint64_t i = 0; i < n; ) {
+        for (uint32_t j = 0; j < EventQueue::CAPACITY && i < n; j++, i++) {
+            queue.Push(mixedEvent(i));
+        }
+        queue.Drain(handler);
+    }
+}
+
+} // namespace
+
+void runEventDispatch()
+{
+    Listener listener;
+
+    const double legacyMove = measureRate(EVENT_COUNT, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            MouseMovedEvent e(static_cast<float>(i & 1023), 1.0f);
+            listener.OnEventLegacy(e);
+        }
+    });
+    report("mouse moved, std::function dispatcher", legacyMove, "events");
+
+    const double tableMove = measureRate(EVENT_COUNT, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            MouseMovedEvent e(static_cast<float>(i & 1023), 1.0f);
+            listener.table.Dispatch(e);
+        }
+    });
+    report("mouse moved, handler table", tableMove, "events");
+
+    const double tableBaseMove = measureRate(EVENT_COUNT, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            MouseMovedEvent e(static_cast<float>(i & 1023), 1.0f);
+            listener.table.Dispatch(static_cast<Event&>(e));
+        }
+    });
+    report("mouse moved, handler table (Event&)", tableBaseMove, "events");
+
+    const double legacyMixed = measureRate(EVENT_COUNT, [&](uint64_t n) {
+        drainMixed(n, [&](Event& e) { listener.OnEventLegacy(e); });
+    });
+    report("mixed queue, std::function dispatcher", legacyMixed, "events");
+
+    const double tableMixed = measureRate(EVENT_COUNT, [&](uint64_t n) {
+        drainMixed(n, [&](auto& e) { listener.table.Dispatch(e); });
+    });
+    report("mixed queue, handler table", tableMixed, "events");
+
+    std::printf("  speedup: %.1fx mouse moved, %.1fx mixed queue\n",
+        tableMove / legacyMove, tableMixed / legacyMixed);
+
+    doNotOptimize(listener.handled);
+}
+
+} // namespace bench
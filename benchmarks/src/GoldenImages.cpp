@@ -0,0 +1,216 @@
+#include "Benchmark.hpp"
+
+#include <string>
+#include <vector>
+
+#include "Scenes.hpp"
+
+namespace bench
+{
+
+using namespace ember;
+
+namespace
+{
+
+struct Image
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> rgb;
+};
+
+// Binary PPM, nothing else needs to be able to read these
+bool writePpm(const std::string& path, const Image& image)
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "P6\n%u %u\n255\n", image.width, image.height);
+    std::fwrite(image.rgb.data(), 1, image.rgb.size(), file);
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+bool readPpm(const std::string& path, Image& image)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    unsigned width = 0, height = 0, maxValue = 0;
+    bool ok = std::fscanf(file, "P6 %u %u %u", &width, &height, &maxValue) == 3 && maxValue == 255 &&
+              std::fgetc(file) != EOF;
+    if (ok) {
+        image.width = width;
+        image.height = height;
+        image.rgb.resize(static_cast<size_t>(width) * height * 3);
+        ok = std::fread(image.rgb.data(), 1, image.rgb.size(), file) == image.rgb.size();
+    }
+    std::fclose(file);
+    return ok;
+}
+
+// directory/DRIVER holds the name of the device the references were
+// rendered on, rasterisation differs enough between drivers that a
+// comparison against another one says little
+std::string readDriver(const std::string& path)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return {};
+
+    char line[VK_MAX_PHYSICAL_DEVICE_NAME_SIZE] = {};
+    const bool ok = std::fgets(line, sizeof(line), file) != nullptr;
+    std::fclose(file);
+    if (!ok)
+        return {};
+
+    std::string driver(line);
+    while (!driver.empty() && (driver.back() == '\n' || driver.back() == '\r'))
+        driver.pop_back();
+    return driver;
+}
+
+bool writeDriver(const std::string& path, const std::string& driver)
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "%s\n", driver.c_str());
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+struct Comparison
+{
+    uint64_t pixelsOver = 0;
+    uint32_t maxDifference = 0;
+    Image diff;
+};
+
+// A pixel fails when any channel is off by more than tolerance. Failing
+// pixels are red in the diff image, brighter the further off they are, the
+// rest is the reference darkened to grey so the failures stand out.
+Comparison compare(const Image& reference, const Image& actual, uint32_t tolerance)
+{
+    Comparison result;
+    result.diff.width = reference.width;
+    result.diff.height = reference.height;
+    result.diff.rgb.resize(reference.rgb.size());
+
+    for (size_t p = 0; p < reference.rgb.size(); p += 3) {
+        uint32_t difference = 0;
+        uint32_t luma = 0;
+        for (size_t c = 0; c < 3; c++) {
+            const int d = static_cast<int>(reference.rgb[p + c]) - static_cast<int>(actual.rgb[p + c]);
+            const uint32_t magnitude = static_cast<uint32_t>(d < 0 ? -d : d);
+            difference = magnitude > difference ? magnitude : difference;
+            luma += reference.rgb[p + c];
+        }
+        result.maxDifference = difference > result.maxDifference ? difference : result.maxDifference;
+
+        uint8_t* out = &result.diff.rgb[p];
+        if (difference > tolerance) {
+            result.pixelsOver++;
+            out[0] = static_cast<uint8_t>(128 + difference / 2);
+            out[1] = 0;
+            out[2] = 0;
+        } else {
+            out[0] = out[1] = out[2] = static_cast<uint8_t>(luma / 12);
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+uint32_t runGolden(const char* directory, uint32_t frames, uint32_t tolerance, bool update)
+{
+    uint32_t failures = 0;
+    const std::string driverPath = std::string(directory) + "/DRIVER";
+    const std::string referenceDriver = update ? std::string() : readDriver(driverPath);
+    bool driverChecked = false;
+
+    for (uint32_t s = 0; s < renderSceneCount; s++) {
+        const RenderScene& scene = renderScenes[s];
+        const std::string base = std::string(directory) + "/" + scene.id;
+
+        Application app(headlessConfig(frames));
+        buildScene(app, scene);
+        app.Run();
+
+        // Every scene runs on the same device, the first one is enough
+        if (!driverChecked) {
+            driverChecked = true;
+            const std::string driver = app.GetDevice()->properties.deviceName;
+            if (update) {
+                if (!writeDriver(driverPath, driver)) {
+                    std::printf("  could not write %s\n", driverPath.c_str());
+                    failures++;
+                }
+            } else if (referenceDriver.empty()) {
+                std::printf("  no %s, rendering on %s\n", driverPath.c_str(), driver.c_str());
+            } else if (referenceDriver != driver) {
+                std::printf("  references are from %s, rendering on %s, expect differences\n",
+                    referenceDriver.c_str(), driver.c_str());
+            }
+        }
+
+        std::vector<uint8_t> rgba;
+        Image actual;
+        if (!app.ReadLastFrame(rgba, actual.width, actual.height)) {
+            std::printf("  %-40s could not read the frame back\n", scene.name);
+            failures++;
+            continue;
+        }
+        actual.rgb.resize(static_cast<size_t>(actual.width) * actual.height * 3);
+        for (size_t i = 0, j = 0; i < rgba.size(); i += 4, j += 3) {
+            actual.rgb[j] = rgba[i];
+            actual.rgb[j + 1] = rgba[i + 1];
+            actual.rgb[j + 2] = rgba[i + 2];
+        }
+
+        if (update) {
+            const bool ok = writePpm(base + ".ppm", actual);
+            std::printf("  %-40s %s %s.ppm\n", scene.name, ok ? "wrote" : "could not write", base.c_str());
+            failures += ok ? 0 : 1;
+            continue;
+        }
+
+        Image reference;
+        if (!readPpm(base + ".ppm", reference)) {
+            std::printf("  %-40s no reference at %s.ppm\n", scene.name, base.c_str());
+            writePpm(base + ".actual.ppm", actual);
+            failures++;
+            continue;
+        }
+        if (reference.width != actual.width || reference.height != actual.height) {
+            std::printf("  %-40s reference is %ux%u, rendered %ux%u\n",
+                scene.name, reference.width, reference.height, actual.width, actual.height);
+            writePpm(base + ".actual.ppm", actual);
+            failures++;
+            continue;
+        }
+
+        const Comparison result = compare(reference, actual, tolerance);
+        if (result.pixelsOver == 0) {
+            std::printf("  %-40s ok, max difference %u\n", scene.name, result.maxDifference);
+            continue;
+        }
+
+        std::printf("  %-40s FAILED, %llu pixels over tolerance, max difference %u\n",
+            scene.name, static_cast<unsigned long long>(result.pixelsOver), result.maxDifference);
+        writePpm(base + ".actual.ppm", actual);
+        writePpm(base + ".diff.ppm", result.diff);
+        failures++;
+    }
+
+    return failures;
+}
+
+} // namespace bench
@@ -0,0 +1,122 @@
+#include "Benchmark.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "Core/JobSystem.hpp"
+#include "Core/Logger.hpp"
+#include "Vulkan/LlyMeshOptimizer.hpp"
+#include "Vulkan/LlyObjLoader.hpp"
+
+namespace bench
+{
+
+using namespace ember;
+
+namespace
+{
+
+// 707x707 quads, a million triangles
+constexpr uint32_t GRID_SIZE = 707;
+constexpr const char* OBJ_PATH = "import_benchmark.obj";
+
+bool writeGrid(const char* path)
+{
+    std::FILE* file = std::fopen(path, "w");
+    if (!file)
+        return false;
+
+    for (uint32_t y = 0; y <= GRID_SIZE; y++) {
+        for (uint32_t x = 0; x <= GRID_SIZE; x++) {
+            std::fprintf(file, "v %.6f %.6f 0.0 %.3f %.3f 1.0\n",
+                static_cast<float>(x) / GRID_SIZE, static_cast<float>(y) / GRID_SIZE,
+                static_cast<float>(x) / GRID_SIZE, static_cast<float>(y) / GRID_SIZE);
+        }
+    }
+
+    // Quads with texture coordinate and normal indices, as exporters write them
+    for (uint32_t y = 0; y < GRID_SIZE; y++) {
+        for (uint32_t x = 0; x < GRID_SIZE; x++) {
+            const uint32_t a = y * (GRID_SIZE + 1) + x + 1;
+            const uint32_t c = a + GRID_SIZE + 1;
+            std::fprintf(file, "f %u/1/1 %u/2/1 %u/3/1 %u/4/1\n", a, a + 1, c + 1, c);
+        }
+    }
+
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+void importWith(uint32_t workers)
+{
+    JobSystem::Config config;
+    config.workerCount = workers;
+    JobSystem::Init(config);
+
+    std::vector<LlyModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    LlyObjLoader::Stats stats;
+    // Once to get the file into the page cache, timed the second time
+    LlyObjLoader::load(OBJ_PATH, vertices, indices);
+    const bool ok = LlyObjLoader::load(OBJ_PATH, vertices, indices, &stats);
+
+    JobSystem::Shutdown();
+
+    if (!ok) {
+        std::printf("  Could not import %s\n", OBJ_PATH);
+        return;
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%u threads, %u chunks", stats.threads, stats.chunks);
+    report(name, stats.bytes / (1024.0 * 1024.0) / stats.totalSeconds, "MB");
+    std::printf("  %-40s %14.0f triangles/s (parse %.1f ms, merge %.1f ms, indices %.1f ms)\n", "",
+        stats.triangles / stats.totalSeconds,
+        stats.parseSeconds * 1000.0, stats.dedupSeconds * 1000.0, stats.indexSeconds * 1000.0);
+    doNotOptimize(indices.back());
+}
+
+void optimizeImported()
+{
+    std::vector<LlyModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    if (!LlyObjLoader::load(OBJ_PATH, vertices, indices))
+        return;
+
+    LlyMeshOptimizer::Stats stats;
+    LlyMeshOptimizer::optimize(vertices, indices, &stats);
+
+    report("Vertex cache and fetch order", stats.after.triangles / stats.seconds, "triangles");
+    std::printf("  %-40s ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (FIFO of %u)\n", "",
+        stats.before.acmr(), stats.after.acmr(), stats.before.atvr(), stats.after.atvr(),
+        LlyMeshOptimizer::DEFAULT_CACHE_SIZE);
+    doNotOptimize(indices.back());
+}
+
+} // namespace
+
+void runImport()
+{
+    // The loader logs, same levels as the render scenes so their
+    // Application finds the logger already set up the way it wants
+    LoggerConfig logging;
+    logging.coreLevel = spdlog::level::warn;
+    logging.appLevel = spdlog::level::warn;
+    Logger::Init(logging);
+
+    if (!writeGrid(OBJ_PATH)) {
+        std::printf("  Could not write %s\n", OBJ_PATH);
+        return;
+    }
+
+    importWith(1);
+    const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    if (hardwareThreads > 1)
+        importWith(hardwareThreads);
+    optimizeImported();
+
+    std::remove(OBJ_PATH);
+}
+
+} // namespace bench
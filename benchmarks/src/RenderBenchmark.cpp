@@ -0,0 +1,85 @@
+#include "Benchmark.hpp"
+
+#include "Scenes.hpp"
+
+namespace bench
+{
+
+using namespace ember;
+
+namespace
+{
+
+void writeSummary(std::FILE* file, const char* key, const FrameStats::Summary& summary, bool last = false)
+{
+    std::fprintf(
+        file,
+        "      \"%s\": {\"count\": %llu, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+        key,
+        static_cast<unsigned long long>(summary.count),
+        summary.mean,
+        summary.p50,
+        summary.p95,
+        summary.p99,
+        summary.max,
+        last ? "" : ",");
+}
+
+} // namespace
+
+bool runRender(uint32_t frames, const char* jsonPath)
+{
+    std::FILE* file = std::fopen(jsonPath, "w");
+    if (!file) {
+        std::printf("  Could not open %s\n", jsonPath);
+        return false;
+    }
+
+    std::fprintf(file, "{\n  \"benchmark\": \"render\",\n  \"revision\": \"%s\",\n", BENCH_REVISION);
+    std::fprintf(file, "  \"frames\": %u,\n  \"width\": %u,\n  \"height\": %u,\n", frames, SCENE_WIDTH, SCENE_HEIGHT);
+
+    for (uint32_t s = 0; s < renderSceneCount; s++) {
+        const RenderScene& scene = renderScenes[s];
+
+        Application app(headlessConfig(frames));
+        if (s == 0)
+            std::fprintf(file, "  \"device\": \"%s\",\n  \"scenes\": [\n", app.GetDevice()->properties.deviceName);
+
+        buildScene(app, scene);
+
+        const AllocationCounts before = allocationCounts();
+        app.Run();
+        const AllocationCounts after = allocationCounts();
+
+        const FrameStats& stats = app.GetFrameStats();
+        const FrameStats::Summary frameTime = stats.GetTotalSummary(FrameStats::FrameTime);
+        std::printf("  %-40s %10.3f ms p50 %10.3f ms p99\n", scene.name, frameTime.p50, frameTime.p99);
+
+        std::fprintf(file, "    {\n");
+        std::fprintf(file, "      \"id\": \"%s\",\n      \"name\": \"%s\",\n", scene.id, scene.name);
+        std::fprintf(file, "      \"objects\": %zu,\n      \"models\": %u,\n      \"pipelines\": %u,\n",
+            app.GetGameObjects().size(), scene.models, scene.pipelines);
+        std::fprintf(file, "      \"instanced\": false,\n      \"recordingThreads\": 1,\n");
+        std::fprintf(file, "      \"allocationsPerFrame\": %.2f,\n      \"allocatedBytesPerFrame\": %.1f,\n",
+            static_cast<double>(after.allocations - before.allocations) / frames,
+            static_cast<double>(after.bytes - before.bytes) / frames);
+        writeSummary(file, "frameMs", frameTime);
+        writeSummary(file, "cpuMs", stats.GetTotalSummary(FrameStats::CpuTime));
+        writeSummary(file, "gpuMs", stats.GetTotalSummary(FrameStats::GpuTime));
+        writeSummary(file, "fenceWaitMs", stats.GetTotalSummary(FrameStats::FenceWait));
+        writeSummary(file, "submitMs", stats.GetTotalSummary(FrameStats::Submit));
+        writeSummary(file, "draws", stats.GetTotalSummary(FrameStats::Draws));
+        writeSummary(file, "pipelineBinds", stats.GetTotalSummary(FrameStats::PipelineBinds));
+        writeSummary(file, "vertexBufferBinds", stats.GetTotalSummary(FrameStats::VertexBufferBinds), true);
+        std::fprintf(file, "    }%s\n", s + 1 < renderSceneCount ? "," : "");
+    }
+
+    std::fprintf(file, "  ]\n}\n");
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+
+    std::printf("  Wrote %s\n", jsonPath);
+    return ok;
+}
+
+} // namespace bench
@@ -0,0 +1,89 @@
+#include "Scenes.hpp"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace bench
+{
+
+using namespace ember;
+
+// Every scene draws one object per draw call and records on the main thread,
+// the renderer has neither instancing nor parallel recording yet
+const RenderScene renderScenes[] = {
+    {"sampleapp", "sampleapp", 0, 0, 0},
+    {"objects", "objects", 10000, 1, 1},
+    {"objects_models", "objects and models", 10000, 64, 1},
+    {"objects_pipelines", "objects and pipelines", 10000, 1, 16},
+    {"objects_models_pipelines", "objects, models and pipelines", 10000, 64, 16},
+};
+const uint32_t renderSceneCount = sizeof(renderScenes) / sizeof(renderScenes[0]);
+
+namespace
+{
+
+// Regular polygons from 3 to 10 sides, fanned into triangles
+std::shared_ptr<LlyModel> makePolygon(const std::shared_ptr<LlyDevice>& device, uint32_t sides)
+{
+    std::vector<LlyModel::Vertex> vertices;
+    const float step = 6.2831853f / sides;
+    for (uint32_t i = 0; i < sides; i++) {
+        const float a = step * i;
+        const float b = step * (i + 1);
+        vertices.push_back({{0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}});
+        vertices.push_back({{0.5f * std::cos(a), 0.5f * std::sin(a)}, {1.0f, 0.0f, 0.0f}});
+        vertices.push_back({{0.5f * std::cos(b), 0.5f * std::sin(b)}, {0.0f, 0.0f, 1.0f}});
+    }
+    return std::make_shared<LlyModel>(device, vertices);
+}
+
+} // namespace
+
+Application::ApplicationConfig headlessConfig(uint32_t frames)
+{
+    Application::ApplicationConfig config{};
+    config.width = SCENE_WIDTH;
+    config.height = SCENE_HEIGHT;
+    config.title = "EmberBench";
+    config.headless = true;
+    config.frameLimit = frames;
+    // Only the summary at the end of Run, and only warnings from the engine
+    config.statsReportSeconds = 1e9f;
+    config.logging.coreLevel = spdlog::level::warn;
+    config.logging.appLevel = spdlog::level::warn;
+    return config;
+}
+
+void buildScene(Application& app, const RenderScene& scene)
+{
+    if (scene.objects == 0)
+        return;
+
+    std::vector<std::shared_ptr<LlyModel>> models;
+    for (uint32_t i = 0; i < scene.models; i++)
+        models.push_back(makePolygon(app.GetDevice(), 3 + i % 8));
+
+    std::vector<std::shared_ptr<LlyPipeline>> pipelines;
+    for (uint32_t i = 0; i < scene.pipelines; i++)
+        pipelines.push_back(app.CreatePipeline());
+
+    // A grid covering the viewport, neighbours overlap a little
+    const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(scene.objects))));
+    const float cell = 2.0f / columns;
+
+    auto& objects = app.GetGameObjects();
+    objects.clear();
+    for (uint32_t i = 0; i < scene.objects; i++) {
+        auto object = GameObject::createGameObject();
+        object.model = models[i % scene.models];
+        object.pipeline = pipelines[i % scene.pipelines];
+        object.transform2d.translation = {-1.0f + cell * (i % columns + 0.5f), -1.0f + cell * (i / columns + 0.5f)};
+        object.transform2d.scale = glm::vec2(cell * 1.5f);
+        object.transform2d.rotation = 0.1f * i;
+        object.color = {(i % 7) / 7.0f, (i % 5) / 5.0f, (i % 3) / 3.0f};
+        objects.push_back(std::move(object));
+    }
+}
+
+} // namespace bench
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Core/Application.hpp"
+
+namespace bench
+{
+
+// A scene the benchmarks and the golden image checks render. With objects
+// set to 0 the application keeps the scene it loads by itself, the
+// sampleapp one.
+struct RenderScene
+{
+    const char* id;     // file name friendly
+    const char* name;
+    uint32_t objects;
+    uint32_t models;
+    uint32_t pipelines;
+};
+
+extern const RenderScene renderScenes[];
+extern const uint32_t renderSceneCount;
+
+constexpr uint32_t SCENE_WIDTH = 640;
+constexpr uint32_t SCENE_HEIGHT = 480;
+
+// Headless, stops after frames and keeps engine logging to warnings
+ember::Application::ApplicationConfig headlessConfig(uint32_t frames);
+void buildScene(ember::Application& app, const RenderScene& scene);
+
+} // namespace bench
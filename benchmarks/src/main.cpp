@@ -0,0 +1,75 @@
+#include "Benchmark.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+constexpr uint32_t GOLDEN_FRAMES = 16;
+
+// EmberBench [--events] [--import] [--render] [--frames N] [--json PATH]
+// EmberBench --golden DIR [--update] [--tolerance N]
+// Runs every benchmark when no suite is picked. --golden checks rendering
+// against the reference images in DIR instead of benchmarking.
+int main(int argc, char** argv)
+{
+    bool events = false;
+    bool import = false;
+    bool render = false;
+    uint32_t frames = 600;
+    const char* jsonPath = "render_benchmark.json";
+    const char* goldenDirectory = nullptr;
+    bool update = false;
+    uint32_t tolerance = 2;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--events") == 0) {
+            events = true;
+        } else if (std::strcmp(argv[i], "--import") == 0) {
+            import = true;
+        } else if (std::strcmp(argv[i], "--render") == 0) {
+            render = true;
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            goldenDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            std::printf("Usage: %s [--events] [--import] [--render] [--frames N] [--json PATH]\n", argv[0]);
+            std::printf("       %s --golden DIR [--update] [--tolerance N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // A fixed frame count, the scenes animate per frame rather than per
+    // second so the last frame is the same on every run
+    if (goldenDirectory) {
+        std::printf("Golden images in %s, tolerance %u\n", goldenDirectory, tolerance);
+        const uint32_t failures = bench::runGolden(goldenDirectory, GOLDEN_FRAMES, tolerance, update);
+        if (failures)
+            std::printf("%u scenes failed\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    if (!events && !import && !render)
+        events = import = render = true;
+
+    if (events) {
+        std::printf("Event dispatch\n");
+        bench::runEventDispatch();
+    }
+
+    if (import) {
+        std::printf("OBJ import\n");
+        bench::runImport();
+    }
+
+    if (render) {
+        std::printf("Headless rendering, %u frames per scene\n", frames);
+        if (!bench::runRender(frames > 0 ? frames : 1, jsonPath))
+            return 1;
+    }
+}
@@ -0,0 +1,173 @@
+#include "Allocators.hpp"
+
+#include <memory>
+#include <stdexcept>
+
+#include "Asserts.hpp"
+#include "Platform/Platform.hpp"
+
+namespace ember
+{
+
+LinearAllocator::LinearAllocator(size_t capacity, MemoryTag tag, std::pmr::memory_resource* upstream)
+    : tag_(tag), upstream_(upstream)
+{
+    void* block = platformAllocate(capacity, true);
+    if (!block)
+        throw std::runtime_error("Could not allocate the linear allocator's block!");
+    MemoryTracker::RecordAllocation(MemoryDomain::Cpu, tag_, capacity);
+
+    begin_ = reinterpret_cast<uintptr_t>(block);
+    current_ = begin_;
+    end_ = begin_ + capacity;
+}
+
+LinearAllocator::~LinearAllocator()
+{
+    Reset();
+    platformFree(reinterpret_cast<void*>(begin_), true);
+    MemoryTracker::RecordFree(MemoryDomain::Cpu, tag_, end_ - begin_);
+}
+
+void* LinearAllocator::AllocateOverflow(size_t size, size_t alignment)
+{
+    // The header takes a whole alignment unit so the memory after it stays
+    // aligned
+    const size_t headerSize = alignment > sizeof(Overflow) ? alignment : (sizeof(Overflow) + alignment - 1) / alignment * alignment;
+    const size_t blockAlignment = alignment > alignof(Overflow) ? alignment : alignof(Overflow);
+
+    auto* header = static_cast<Overflow*>(upstream_->allocate(headerSize + size, blockAlignment));
+    header->next = overflow_;
+    header->size = headerSize + size;
+    header->alignment = blockAlignment;
+    overflow_ = header;
+    MemoryTracker::RecordAllocation(MemoryDomain::Cpu, tag_, header->size);
+
+    overflowBytes_ += size;
+    overflowAllocations_++;
+    return reinterpret_cast<char*>(header) + headerSize;
+}
+
+void LinearAllocator::Rewind(const Marker& marker)
+{
+    EM_CORE_ASSERT(marker.position >= begin_ && marker.position <= current_, "Rewinding past the current position");
+
+    peak_ = current_ - begin_ > peak_ ? current_ - begin_ : peak_;
+    current_ = marker.position;
+
+    while (overflow_ && overflow_ != marker.overflow) {
+        Overflow* next = overflow_->next;
+        MemoryTracker::RecordFree(MemoryDomain::Cpu, tag_, overflow_->size);
+        upstream_->deallocate(overflow_, overflow_->size, overflow_->alignment);
+        overflow_ = next;
+    }
+}
+
+void LinearAllocator::Reset()
+{
+    Rewind(Marker{begin_, nullptr});
+    overflowBytes_ = 0;
+    overflowAllocations_ = 0;
+}
+
+LinearAllocator::Stats LinearAllocator::GetStats() const
+{
+    Stats stats;
+    stats.capacity = end_ - begin_;
+    stats.used = current_ - begin_;
+    stats.peak = stats.used > peak_ ? stats.used : peak_;
+    stats.overflowBytes = overflowBytes_;
+    stats.overflowAllocations = overflowAllocations_;
+    return stats;
+}
+
+PoolAllocator::PoolAllocator(
+    size_t blockSize,
+    uint32_t blockCount,
+    size_t blockAlignment,
+    MemoryTag tag,
+    std::pmr::memory_resource* upstream)
+    : tag_(tag), upstream_(upstream), blockCount_(blockCount)
+{
+    // Free blocks hold the list pointer
+    blockAlignment_ = blockAlignment > alignof(FreeBlock) ? blockAlignment : alignof(FreeBlock);
+    blockSize = blockSize > sizeof(FreeBlock) ? blockSize : sizeof(FreeBlock);
+    blockSize_ = (blockSize + blockAlignment_ - 1) / blockAlignment_ * blockAlignment_;
+
+    void* memory = platformAllocateAligned(blockSize_ * blockCount_, blockAlignment_);
+    if (!memory)
+        throw std::runtime_error("Could not allocate the pool's blocks!");
+    MemoryTracker::RecordAllocation(MemoryDomain::Cpu, tag_, blockSize_ * blockCount_);
+
+    begin_ = reinterpret_cast<uintptr_t>(memory);
+    end_ = begin_ + blockSize_ * blockCount_;
+
+    // Threaded front to back so blocks are handed out in address order
+    freeList_ = nullptr;
+    for (uint32_t i = blockCount_; i > 0; i--) {
+        auto* block = reinterpret_cast<FreeBlock*>(begin_ + blockSize_ * (i - 1));
+        block->next = freeList_;
+        freeList_ = block;
+    }
+}
+
+PoolAllocator::~PoolAllocator()
+{
+    EM_CORE_ASSERT(blocksUsed_ == 0, "Pool destroyed with blocks still in use");
+    platformFreeAligned(reinterpret_cast<void*>(begin_));
+    MemoryTracker::RecordFree(MemoryDomain::Cpu, tag_, end_ - begin_);
+}
+
+void* PoolAllocator::Allocate(size_t size, size_t alignment)
+{
+    if (EM_UNLIKELY(size > blockSize_ || alignment > blockAlignment_ || !freeList_)) {
+        overflowAllocations_++;
+        MemoryTracker::RecordAllocation(MemoryDomain::Cpu, tag_, size);
+        return upstream_->allocate(size, alignment);
+    }
+
+    FreeBlock* block = freeList_;
+    freeList_ = block->next;
+
+    blocksUsed_++;
+    peakBlocksUsed_ = blocksUsed_ > peakBlocksUsed_ ? blocksUsed_ : peakBlocksUsed_;
+    return block;
+}
+
+void PoolAllocator::Free(void* block, size_t size, size_t alignment)
+{
+    if (!block)
+        return;
+
+    if (EM_UNLIKELY(!Owns(block))) {
+        MemoryTracker::RecordFree(MemoryDomain::Cpu, tag_, size);
+        upstream_->deallocate(block, size, alignment);
+        return;
+    }
+
+    auto* freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = freeList_;
+    freeList_ = freeBlock;
+    blocksUsed_--;
+}
+
+PoolAllocator::Stats PoolAllocator::GetStats() const
+{
+    Stats stats;
+    stats.blockSize = blockSize_;
+    stats.blockCount = blockCount_;
+    stats.blocksUsed = blocksUsed_;
+    stats.peakBlocksUsed = peakBlocksUsed_;
+    stats.overflowAllocations = overflowAllocations_;
+    return stats;
+}
+
+LinearAllocator& ScratchArena::Get()
+{
+    thread_local std::unique_ptr<LinearAllocator> arena;
+    if (!arena)
+        arena = std::make_unique<LinearAllocator>(CAPACITY, MemoryTag::Scratch);
+    return *arena;
+}
+
+} // namespace ember
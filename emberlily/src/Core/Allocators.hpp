@@ -0,0 +1,272 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+#include "MemoryTracker.hpp"
+
+namespace ember
+{
+
+// Every allocator here is a std::pmr::memory_resource, so std::pmr
+// containers can allocate from them directly:
+//
+//   std::pmr::vector<RenderPacket> packets(&app.GetFrameAllocator());
+//
+// None of them is thread safe, share one between threads only behind a lock
+// or give every thread its own (see ScratchArena). Their blocks are charged
+// to a MemoryTag in the MemoryTracker.
+
+// Forwards to another resource and charges what goes through it to a tag,
+// for containers whose memory should show up in the memory report:
+//
+//   TaggedMemoryResource modelMemory(MemoryTag::Models);
+//   std::pmr::vector<LlyModel::Vertex> vertices(&modelMemory);
+class TaggedMemoryResource : public std::pmr::memory_resource
+{
+public:
+    explicit TaggedMemoryResource(MemoryTag tag, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : tag_(tag), upstream_(upstream)
+    {
+    }
+
+    inline MemoryTag GetTag() const { return tag_; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* block = upstream_->allocate(bytes, alignment);
+        MemoryTracker::RecordAllocation(MemoryDomain::Cpu, tag_, bytes);
+        return block;
+    }
+
+    void do_deallocate(void* block, size_t bytes, size_t alignment) override
+    {
+        upstream_->deallocate(block, bytes, alignment);
+        MemoryTracker::RecordFree(MemoryDomain::Cpu, tag_, bytes);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    MemoryTag tag_;
+    std::pmr::memory_resource* upstream_;
+};
+
+// Bump allocator over one fixed block. Allocating moves a pointer forward,
+// freeing single allocations does nothing, Reset or Rewind frees everything
+// allocated after a point at once. Requests that don't fit anymore go to
+// the upstream resource and are counted, so an undersized arena shows up in
+// the stats instead of failing.
+class LinearAllocator : public std::pmr::memory_resource
+{
+public:
+    struct Stats
+    {
+        size_t capacity = 0;
+        size_t used = 0;
+        // Highest used since the allocator was created
+        size_t peak = 0;
+        // Bytes that went to the upstream resource since the last Reset
+        size_t overflowBytes = 0;
+        uint32_t overflowAllocations = 0;
+    };
+
+    // Position to rewind to, covers overflow allocations too
+    struct Marker
+    {
+        uintptr_t position;
+        const void* overflow;
+    };
+
+    explicit LinearAllocator(
+        size_t capacity,
+        MemoryTag tag = MemoryTag::Untagged,
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+    ~LinearAllocator() override;
+
+    // Delete copy contructors
+    LinearAllocator(const LinearAllocator&) = delete;
+    LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+    inline void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+        const uintptr_t aligned = (current_ + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        if (aligned + size > end_ || aligned < current_)
+            return AllocateOverflow(size, alignment);
+
+        current_ = aligned + size;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    template<typename T>
+    T* AllocateArray(size_t count)
+    {
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    inline Marker GetMarker() const { return Marker{current_, overflow_}; }
+    // Frees everything allocated after marker was taken
+    void Rewind(const Marker& marker);
+    // Frees everything, overflow allocations included
+    void Reset();
+
+    Stats GetStats() const;
+
+private:
+    struct Overflow
+    {
+        Overflow* next;
+        size_t size;
+        size_t alignment;
+    };
+
+    void* AllocateOverflow(size_t size, size_t alignment);
+
+    void* do_allocate(size_t bytes, size_t alignment) override { return Allocate(bytes, alignment); }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    MemoryTag tag_;
+    std::pmr::memory_resource* upstream_;
+    uintptr_t begin_;
+    uintptr_t current_;
+    uintptr_t end_;
+    size_t peak_ = 0;
+
+    // Overflow blocks, each with its header in front
+    Overflow* overflow_ = nullptr;
+    size_t overflowBytes_ = 0;
+    uint32_t overflowAllocations_ = 0;
+};
+
+// Fixed size blocks carved out of one allocation, free blocks are kept in an
+// intrusive list so allocating and freeing are a couple of pointer moves.
+// Requests bigger than a block, or made while the pool is empty, go to the
+// upstream resource.
+class PoolAllocator : public std::pmr::memory_resource
+{
+public:
+    struct Stats
+    {
+        size_t blockSize = 0;
+        uint32_t blockCount = 0;
+        uint32_t blocksUsed = 0;
+        uint32_t peakBlocksUsed = 0;
+        uint32_t overflowAllocations = 0;
+    };
+
+    // Blocks are aligned to blockAlignment, at least pointer size
+    PoolAllocator(
+        size_t blockSize,
+        uint32_t blockCount,
+        size_t blockAlignment = alignof(std::max_align_t),
+        MemoryTag tag = MemoryTag::Untagged,
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+    ~PoolAllocator() override;
+
+    // Delete copy contructors
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    void Free(void* block, size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Constructs a T in a block
+    template<typename T, typename... Args>
+    T* New(Args&&... args)
+    {
+        return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    void Delete(T* object)
+    {
+        if (!object)
+            return;
+        object->~T();
+        Free(object, sizeof(T), alignof(T));
+    }
+
+    inline bool Owns(const void* block) const
+    {
+        const auto address = reinterpret_cast<uintptr_t>(block);
+        return address >= begin_ && address < end_;
+    }
+
+    Stats GetStats() const;
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override { return Allocate(bytes, alignment); }
+    void do_deallocate(void* block, size_t bytes, size_t alignment) override { Free(block, bytes, alignment); }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    MemoryTag tag_;
+    std::pmr::memory_resource* upstream_;
+    size_t blockSize_;
+    size_t blockAlignment_;
+    uint32_t blockCount_;
+    uintptr_t begin_;
+    uintptr_t end_;
+
+    FreeBlock* freeList_;
+    uint32_t blocksUsed_ = 0;
+    uint32_t peakBlocksUsed_ = 0;
+    uint32_t overflowAllocations_ = 0;
+};
+
+// Per thread linear allocator for temporary memory that doesn't outlive the
+// function using it. Open a ScratchScope, allocate, and everything is freed
+// when the scope closes:
+//
+//   ScratchScope scratch;
+//   std::pmr::vector<uint32_t> indices(&scratch.Resource());
+class ScratchArena
+{
+public:
+    static constexpr size_t CAPACITY = 1024 * 1024;
+
+    // The calling thread's arena, created on first use
+    static LinearAllocator& Get();
+};
+
+class ScratchScope
+{
+public:
+    ScratchScope()
+        : arena_(ScratchArena::Get()), marker_(arena_.GetMarker())
+    {
+    }
+
+    ~ScratchScope() { arena_.Rewind(marker_); }
+
+    // Delete copy contructors
+    ScratchScope(const ScratchScope&) = delete;
+    ScratchScope& operator=(const ScratchScope&) = delete;
+
+    inline LinearAllocator& Resource() { return arena_; }
+
+    inline void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+        return arena_.Allocate(size, alignment);
+    }
+
+    template<typename T>
+    T* AllocateArray(size_t count)
+    {
+        return arena_.AllocateArray<T>(count);
+    }
+
+private:
+    LinearAllocator& arena_;
+    LinearAllocator::Marker marker_;
+};
+
+} // namespace ember
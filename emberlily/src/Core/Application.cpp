@@ -1,5 +1,14 @@
 #include "Application.hpp"
 
+#include "Clock.hpp"
+#include "FiberScheduler.hpp"
+#include "FlightRecorder.hpp"
+#include "Input.hpp"
+#include "JobSystem.hpp"
+#include "Profiler.hpp"
+
+#include <stdexcept>
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -8,21 +17,24 @@
 namespace ember
 {
 
+// Objects per job when updating transforms, smaller scenes stay on the main
+// thread
+static constexpr uint32_t TRANSFORM_BATCH_SIZE = 1024;
+
 struct SimplePushConstantData {
     glm::mat2 transform{1.f};
     glm::vec2 offset;
     alignas(16) glm::vec3 color;
 };
 
-#define BIND_EVENT_FN(x) std::bind(&x, this, std::placeholders::_1)
-
 bool Application::initialized = false;
 
 Application::Application(const ApplicationConfig& config)
     : config_(config)
 {
     // First init the logger
-    Logger::Init();
+    Logger::Init(config_.logging);
+    FlightRecorder::Init("flight_record.bin");
 
     if (Application::initialized) {
         EM_LOG_ERROR("Application already initialized");
@@ -32,12 +44,42 @@ Application::Application(const ApplicationConfig& config)
     state_.isRunning = true;
     state_.isSuspended = false;
 
-    window_ = std::make_shared<LlyWindow>(config_.title, config_.width, config_.height);
-    window_->SetEventCallback(BIND_EVENT_FN(Application::OnEvent));
+    registerEventHandlers();
+
+    frameStats_ = std::make_unique<FrameStats>(config_.statsReportSeconds > 0.0f ? config_.statsReportSeconds : 10.0);
+    frameAllocator_ = std::make_unique<LinearAllocator>(
+        config_.frameAllocatorSize > 0 ? config_.frameAllocatorSize : 4 * 1024 * 1024, MemoryTag::Frame);
+
+    // Headless there is no window at all, the device goes without a surface
+    if (!config_.headless) {
+        window_ = std::make_shared<LlyWindow>(config_.title, config_.width, config_.height);
+        window_->getEventQueue().SetCoalescing(!config_.rawMouseEvents);
+    }
 
     Application::initialized = true;
 
+    JobSystem::Config jobConfig;
+    jobConfig.workerCount = config_.workerThreads;
+    if (config_.pinWorkerThreads) {
+        jobConfig.onWorkerStart = [](uint32_t workerIndex) {
+            if (!JobSystem::PinCurrentThread(workerIndex))
+                EM_LOG_WARN("Could not pin worker {0}", workerIndex);
+        };
+    }
+    JobSystem::Init(jobConfig);
+    FiberScheduler::Init();
+    EM_LOG_INFO("Job system running {0} workers", JobSystem::GetWorkerCount());
+
     device_ = std::make_shared<LlyDevice>(window_);
+    LlyAssetStreamer::Config streamingConfig;
+    streamingConfig.ioThreads = config_.streamingThreads;
+    streamingConfig.stagingSize = config_.streamingBufferSize;
+    assetStreamer_ = std::make_unique<LlyAssetStreamer>(device_, streamingConfig);
+#ifdef EM_ENABLE_PROFILER
+    gpuProfiler_ = std::make_unique<LlyGpuProfiler>(device_, LlySwapChain::MAX_FRAMES_IN_FLIGHT);
+#endif
+    if (config_.pipelineStatistics)
+        pipelineStats_ = std::make_unique<LlyPipelineStatistics>(device_, LlySwapChain::MAX_FRAMES_IN_FLIGHT);
     // swapChain_ = std::make_unique<LlySwapChain>(device_, window_->getExtent());
 
     loadGameObjects();
@@ -50,37 +92,129 @@ Application::Application(const ApplicationConfig& config)
 Application::~Application()
 {
     vkDestroyPipelineLayout(device_->device(), pipelineLayout_, nullptr);
+
+    // Waits for the fiber jobs, which needs the workers, before the job
+    // system drains the rest and joins them
+    FiberScheduler::Shutdown();
+    JobSystem::Shutdown();
+
+    // Another application can be created once this one is gone
+    Application::initialized = false;
+
+    // Its I/O threads log, they have to be joined before the loggers are
+    // swapped. Job workers are already gone.
+    assetStreamer_.reset();
+
+    // Anything logged while the members are destroyed is written synchronously
+    Logger::Shutdown();
 }
 
 void Application::Run()
 {
+    lastFrameTicks_ = Clock::Ticks();
+
     while(state_.isRunning)
     {
-        state_.isRunning = !window_->shouldWindowClose();
-
-        window_->update();
-        drawFrame();
+        if (window_)
+            state_.isRunning = !window_->shouldWindowClose();
+
+        const uint64_t frameStart = Clock::Ticks();
+        state_.deltaTime = static_cast<float>(Clock::TicksToSeconds(frameStart - lastFrameTicks_));
+        lastFrameTicks_ = frameStart;
+
+        EM_RECORD("Frame {0} begin", frameIndex_);
+
+        // Anything that didn't fit last frame went to the heap, worth
+        // knowing about but only the first time
+        const auto frameMemory = frameAllocator_->GetStats();
+        if (frameMemory.overflowAllocations > 0 && frameAllocatorOverflows_++ == 0) {
+            EM_LOG_WARN(
+                "Frame allocator overflowed: {0} allocations, {1} bytes past its {2} bytes",
+                frameMemory.overflowAllocations,
+                frameMemory.overflowBytes,
+                frameMemory.capacity);
+        }
+        frameAllocator_->Reset();
+
+        if (frameIndex_ == 0 && config_.profileCaptureFrames > 0)
+            Profiler::BeginCapture();
+
+        {
+            EM_PROFILE_SCOPE("Frame");
+
+            {
+                EM_PROFILE_SCOPE("Events");
+
+                if (window_) {
+                    window_->update();
+                    // Process everything the window received since the last frame in one go
+                    window_->getEventQueue().Drain([this](auto& e) {
+                        EM_RECORD("Event type {0}", e.GetEventType());
+                        Input::OnEvent(e);
+                        eventHandlers_.Dispatch(e);
+                    });
+                }
+                // Polled input queries see this frame's state from here on
+                Input::Publish();
+            }
+
+            drawFrame();
+        }
+
+        recordFrameStats(Clock::Ticks() - frameStart);
+        EM_PROFILE_END_FRAME();
+        EM_RECORD("Frame {0} end", frameIndex_);
+        frameIndex_++;
+
+        if (config_.frameLimit > 0 && frameIndex_ >= config_.frameLimit)
+            state_.isRunning = false;
+
+        if (frameIndex_ == config_.profileCaptureFrames && Profiler::IsCapturing())
+            Profiler::EndCapture("profile_capture.json");
     }
 
+    // The frame limit or the window closing can end the run before the
+    // capture is full, keep what it has
+    if (Profiler::IsCapturing())
+        Profiler::EndCapture("profile_capture.json");
+
     vkDeviceWaitIdle(device_->device());
 
+    frameStats_->LogTotal();
+    LogMemoryReport();
+
     // Explicitly set it to false here too in case it's set 
     // in another part of the application 
     state_.isRunning = false;
 }
 
+bool Application::ReadLastFrame(std::vector<uint8_t>& rgba, uint32_t& width, uint32_t& height)
+{
+    if (!swapChain_->isHeadless())
+        return false;
+
+    swapChain_->readLastImage(rgba);
+    width = swapChain_->width();
+    height = swapChain_->height();
+    return true;
+}
+
 void Application::OnEvent(Event& e)
 {
-    EventDispatcher dispatcher(e);
-    dispatcher.Dispatch<WindowCloseEvent>(BIND_EVENT_FN(Application::OnWindowClose));
-    dispatcher.Dispatch<WindowResizeEvent>(BIND_EVENT_FN(Application::OnWindowResize));
-    dispatcher.Dispatch<KeyPressedEvent>(BIND_EVENT_FN(Application::OnKeyPressed));
-    dispatcher.Dispatch<KeyRepeatEvent>(BIND_EVENT_FN(Application::OnKeyRepeat));
-    dispatcher.Dispatch<KeyReleasedEvent>(BIND_EVENT_FN(Application::OnKeyReleased));
-    dispatcher.Dispatch<MouseButtonPressedEvent>(BIND_EVENT_FN(Application::OnMouseButtonPressed));
-    dispatcher.Dispatch<MouseButtonReleasedEvent>(BIND_EVENT_FN(Application::OnMouseButtonReleased));
-    dispatcher.Dispatch<MouseMovedEvent>(BIND_EVENT_FN(Application::OnMouseMoved));
-    dispatcher.Dispatch<MouseScrolledEvent>(BIND_EVENT_FN(Application::OnMouseScrolled));
+    eventHandlers_.Dispatch(e);
+}
+
+void Application::registerEventHandlers()
+{
+    eventHandlers_.Register<WindowCloseEvent, Application, &Application::OnWindowClose>(this);
+    eventHandlers_.Register<WindowResizeEvent, Application, &Application::OnWindowResize>(this);
+    eventHandlers_.Register<KeyPressedEvent, Application, &Application::OnKeyPressed>(this);
+    eventHandlers_.Register<KeyRepeatEvent, Application, &Application::OnKeyRepeat>(this);
+    eventHandlers_.Register<KeyReleasedEvent, Application, &Application::OnKeyReleased>(this);
+    eventHandlers_.Register<MouseButtonPressedEvent, Application, &Application::OnMouseButtonPressed>(this);
+    eventHandlers_.Register<MouseButtonReleasedEvent, Application, &Application::OnMouseButtonReleased>(this);
+    eventHandlers_.Register<MouseMovedEvent, Application, &Application::OnMouseMoved>(this);
+    eventHandlers_.Register<MouseScrolledEvent, Application, &Application::OnMouseScrolled>(this);
 }
 
 bool Application::OnWindowClose(WindowCloseEvent& e)
@@ -187,10 +321,21 @@ void Application::createPipelineLayout()
     pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
     VkResult ok = vkCreatePipelineLayout(device_->device(), &pipelineLayoutInfo, nullptr, &pipelineLayout_);
-    EM_CORE_ASSERT(ok == VK_SUCCESS, "Could not create pipeline layout!");
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Could not create pipeline layout!");
 }
 
 void Application::createPipeline()
+{
+    // One per format up front, a model in any format can be attached or
+    // streamed in later without compiling a pipeline while recording
+    for (size_t i = 0; i < pipelines_.size(); i++)
+        pipelines_[i].reset();
+    for (size_t i = 0; i < pipelines_.size(); i++)
+        pipelines_[i] = CreatePipeline(static_cast<VertexFormat>(i));
+}
+
+std::shared_ptr<LlyPipeline> Application::CreatePipeline(VertexFormat format)
 {
     EM_CORE_ASSERT(swapChain_ != nullptr, "Cannot create pipeline before swap chain");
     EM_CORE_ASSERT(pipelineLayout_ != nullptr, "Cannot create pipeline before pipeline layout");
@@ -201,7 +346,8 @@ void Application::createPipeline()
 
     configInfo.renderPass = swapChain_->getRenderPass();
     configInfo.pipelineLayout = pipelineLayout_;
-    pipeline_ = std::make_shared<LlyPipeline>(
+    configInfo.vertexFormat = format;
+    return std::make_shared<LlyPipeline>(
         device_,
         configInfo,
         "../../../../shaders/bin/simple_shader.vert.spv", 
@@ -219,7 +365,8 @@ void Application::createCommandBuffers()
     allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers_.size());
 
     VkResult ok = vkAllocateCommandBuffers(device_->device(), &allocInfo, commandBuffers_.data());
-    EM_CORE_ASSERT(ok == VK_SUCCESS, "Couldn't create command buffer!");
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Couldn't create command buffer!");
 }
 
 void Application::freeCommandBuffers()
@@ -234,36 +381,61 @@ void Application::freeCommandBuffers()
 
 void Application::drawFrame()
 {
+    EM_PROFILE_FUNCTION();
+
     uint32_t imageIndex;
     auto result = swapChain_->acquireNextImage(&imageIndex);
+    EM_RECORD("Acquire image {1} result {0}", result, imageIndex);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         recreateSwapChain();
         return;
     }
 
-    EM_CORE_ASSERT((result != VK_SUCCESS || result != VK_SUBOPTIMAL_KHR), "Not good aquire next image from swap chain");
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+        throw std::runtime_error("Could not acquire the next swap chain image!");
+
+    // Uploads staged since last frame go to the transfer queue, this frame
+    // waits for them and can draw them already
+    assetStreamer_->beginFrame();
 
     recordCommandBuffer(imageIndex);
-    result = swapChain_->submitCommandBuffers(&commandBuffers_[imageIndex], &imageIndex);
+    if (gpuProfiler_)
+        gpuProfiler_->endFrame();
+    if (pipelineStats_) {
+        pipelineStats_->endFrame();
+        logPipelineStatistics();
+    }
+    result = swapChain_->submitCommandBuffers(
+        &commandBuffers_[imageIndex], &imageIndex, assetStreamer_->getFrameSemaphore());
+    EM_RECORD("Submit and present result {0}", result);
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window_->wasWindowResized()) {
-        window_->resetWindowResizedFlag();
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || (window_ && window_->wasWindowResized())) {
+        if (window_)
+            window_->resetWindowResizedFlag();
         recreateSwapChain();
         return;
     }
 
-    EM_CORE_ASSERT(result == VK_SUCCESS, "Failed to sbumit command buffer");
+    if (result != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit command buffer!");
 }
 
 void Application::recreateSwapChain()
 {
-    auto extent = window_->getExtent();
-    while (extent.width == 0 || extent.height == 0) {
+    EM_PROFILE_FUNCTION();
+
+    VkExtent2D extent{config_.width, config_.height};
+    if (window_) {
         extent = window_->getExtent();
-        glfwWaitEvents();
+        while (extent.width == 0 || extent.height == 0) {
+            extent = window_->getExtent();
+            glfwWaitEvents();
+        }
     }
 
+    EM_RECORD("Recreate swap chain {0}x{1}", extent.width, extent.height);
+
     vkDeviceWaitIdle(device_->device());
     if (swapChain_ == nullptr) {
         swapChain_ = std::make_unique<LlySwapChain>(device_, extent);
@@ -280,11 +452,24 @@ void Application::recreateSwapChain()
 
 void Application::recordCommandBuffer(int imageIndex)
 {
+    EM_PROFILE_FUNCTION();
+
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
     VkResult ok = vkBeginCommandBuffer(commandBuffers_[imageIndex], &beginInfo);
-    EM_CORE_ASSERT(ok == VK_SUCCESS, "Failed to begin recording command buffer!");
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Failed to begin recording command buffer!");
+
+    // Results of the frame that last used this slot come back here, they
+    // go to the profiler's GPU track
+    if (gpuProfiler_) {
+        gpuProfiler_->beginFrame(commandBuffers_[imageIndex], static_cast<uint32_t>(swapChain_->getCurrentFrame()));
+        gpuProfiler_->beginScope("GPU frame");
+    }
+    if (pipelineStats_)
+        pipelineStats_->beginFrame(commandBuffers_[imageIndex], static_cast<uint32_t>(swapChain_->getCurrentFrame()));
+    assetStreamer_->recordAcquireBarriers(commandBuffers_[imageIndex]);
 
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -303,6 +488,8 @@ void Application::recordCommandBuffer(int imageIndex)
 
     vkCmdBeginRenderPass(commandBuffers_[imageIndex], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
+    commandRecorder_.begin(commandBuffers_[imageIndex]);
+
     VkViewport viewport{};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
@@ -315,45 +502,176 @@ void Application::recordCommandBuffer(int imageIndex)
     scissor.offset = {0, 0};
     scissor.extent = swapChain_->getSwapChainExtent();
 
-    vkCmdSetViewport(commandBuffers_[imageIndex], 0, 1, &viewport);
-    vkCmdSetScissor(commandBuffers_[imageIndex], 0, 1, &scissor);
+    commandRecorder_.setViewport(viewport);
+    commandRecorder_.setScissor(scissor);
 
-    renderGameObjects(commandBuffers_[imageIndex]);
+    renderGameObjects(commandRecorder_);
 
     vkCmdEndRenderPass(commandBuffers_[imageIndex]);
 
+    if (gpuProfiler_)
+        gpuProfiler_->endScope();
+
     ok = vkEndCommandBuffer(commandBuffers_[imageIndex]);
-    EM_CORE_ASSERT(ok == VK_SUCCESS, "Failed to end recording command buffer!");
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Failed to end recording command buffer!");
 }
 
-void Application::renderGameObjects(VkCommandBuffer commandBuffer)
+void Application::renderGameObjects(LlyCommandRecorder& recorder)
 {
-    int i = 0;
-    for (auto& obj : gameObjects_) {
-        i += 1;
-        obj.transform2d.rotation =
-            glm::mod<float>(obj.transform2d.rotation + 0.00001f * i, 2.f * glm::pi<float>());
+    EM_PROFILE_FUNCTION();
+
+    {
+        EM_PROFILE_SCOPE("Update transforms");
+        JobSystem::ParallelFor(
+            static_cast<uint32_t>(gameObjects_.size()), TRANSFORM_BATCH_SIZE, [this](uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; i++) {
+                    auto& obj = gameObjects_[i];
+                    obj.transform2d.rotation =
+                        glm::mod<float>(obj.transform2d.rotation + 0.00001f * (i + 1), 2.f * glm::pi<float>());
+                }
+            });
+    }
+
+    renderQueue_.clear();
+    for (uint32_t index = 0; index < gameObjects_.size(); index++) {
+        auto& obj = gameObjects_[index];
+        LlyPipeline* pipeline =
+            obj.pipeline ? obj.pipeline.get() : pipelines_[static_cast<size_t>(obj.model->getVertexFormat())].get();
+        renderQueue_.submit(pipeline, obj.model.get(), index, obj.layer);
     }
+    {
+        EM_PROFILE_SCOPE("Sort draws");
+        renderQueue_.sort();
+    }
+
+    EM_PROFILE_GPU_SCOPE(gpuProfiler_.get(), "Draw game objects");
+
+    // Packets come out grouped by pipeline and model, the recorder drops the
+    // binds that repeat the current state
+    const LlyPipeline* groupPipeline = nullptr;
+    const LlyModel* groupModel = nullptr;
 
-    pipeline_->bind(commandBuffer);
+    for (const auto& packet : renderQueue_.packets()) {
+        auto& obj = gameObjects_[packet.objectIndex];
+
+        // One statistics query per run of draws sharing a pipeline and a model
+        if (pipelineStats_ && (packet.pipeline != groupPipeline || packet.model != groupModel)) {
+            if (groupPipeline)
+                pipelineStats_->endGroup();
+            pipelineStats_->beginGroup();
+            groupPipeline = packet.pipeline;
+            groupModel = packet.model;
+        }
+
+        packet.pipeline->bind(recorder);
+
+        // Snorm positions are decoded by the transform: scaling them first
+        // and moving the offset through the object's transform
+        const PositionDecode& decode = packet.model->getPositionDecode();
+        const glm::mat2 transform = obj.transform2d.mat2();
 
-    for (auto& obj: gameObjects_) {
         SimplePushConstantData push{};
-        push.offset = obj.transform2d.translation;
+        push.offset = obj.transform2d.translation + transform * glm::vec2{decode.offset[0], decode.offset[1]};
         push.color = obj.color;
-        push.transform = obj.transform2d.mat2();
+        push.transform = transform * glm::mat2{{decode.scale[0], 0.0f}, {0.0f, decode.scale[1]}};
 
-        vkCmdPushConstants(
-            commandBuffer,
+        recorder.pushConstants(
             pipelineLayout_,
             VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
             0,
             sizeof(SimplePushConstantData),
             &push);
 
-        obj.model->bind(commandBuffer);
-        obj.model->draw(commandBuffer);
+        packet.model->bind(recorder);
+        packet.model->draw(recorder);
+    }
+
+    if (pipelineStats_ && groupPipeline)
+        pipelineStats_->endGroup();
+}
+
+void Application::recordFrameStats(uint64_t frameTicks)
+{
+    const auto toMilliseconds = [](uint64_t ticks) { return Clock::TicksToSeconds(ticks) * 1000.0; };
+
+    const auto& timings = swapChain_->getLastTimings();
+    const auto& commands = commandRecorder_.getStats();
+
+    // The first delta only covers the time since Run was called
+    if (frameIndex_ > 0)
+        frameStats_->Record(FrameStats::FrameTime, state_.deltaTime * 1000.0);
+
+    // Only frames the GPU profiler read back since the last call
+    if (gpuProfiler_ && gpuProfiler_->getFramesCollected() != gpuFramesRecorded_) {
+        gpuFramesRecorded_ = gpuProfiler_->getFramesCollected();
+        frameStats_->Record(FrameStats::GpuTime, gpuProfiler_->getLastFrameMilliseconds());
+    }
+
+    const uint64_t blockedTicks = timings.fenceWaitTicks + timings.acquireTicks;
+    frameStats_->Record(FrameStats::CpuTime, toMilliseconds(frameTicks > blockedTicks ? frameTicks - blockedTicks : 0));
+    frameStats_->Record(FrameStats::FenceWait, toMilliseconds(timings.fenceWaitTicks));
+    frameStats_->Record(FrameStats::Acquire, toMilliseconds(timings.acquireTicks));
+    frameStats_->Record(FrameStats::Submit, toMilliseconds(timings.submitTicks));
+    frameStats_->Record(FrameStats::Present, toMilliseconds(timings.presentTicks));
+    frameStats_->Record(FrameStats::Draws, commands.draws);
+    frameStats_->Record(FrameStats::PipelineBinds, commands.pipelineBinds);
+    frameStats_->Record(FrameStats::VertexBufferBinds, commands.vertexBufferBinds);
+
+    if (frameStats_->EndFrame() && config_.memoryReports)
+        LogMemoryReport();
+}
+
+void Application::LogMemoryReport() const
+{
+    MemoryTracker::LogReport();
+
+    const char* budgetNote = device_->hasMemoryBudget() ? "" : " (no VK_EXT_memory_budget, budget unknown)";
+    EM_LOG_INFO("Device memory heaps{0}:", budgetNote);
+    const auto heaps = device_->getHeapBudgets();
+    for (size_t i = 0; i < heaps.size(); i++) {
+        const HeapBudget& heap = heaps[i];
+        EM_LOG_INFO(
+            "  heap {0} ({1}): {2:.1f} MB tracked, {3:.1f} MB used of {4:.1f} MB budget, {5:.1f} MB total",
+            i,
+            heap.deviceLocal ? "device local" : "host",
+            heap.tracked / (1024.0 * 1024.0),
+            heap.usage / (1024.0 * 1024.0),
+            heap.budget / (1024.0 * 1024.0),
+            heap.size / (1024.0 * 1024.0));
     }
 }
 
+void Application::logPipelineStatistics()
+{
+    // Once per averaging window, on the frame the window fills up
+    const uint64_t frames = pipelineStats_->getFramesCollected();
+    if (frames == 0 || frames % LlyPipelineStatistics::AVERAGE_FRAMES != 0 || frames == loggedStatsFrames_)
+        return;
+    loggedStatsFrames_ = frames;
+
+    const auto& last = pipelineStats_->getLastFrame();
+    const auto average = pipelineStats_->getAverage();
+    const auto extent = swapChain_->getSwapChainExtent();
+    const double pixels = static_cast<double>(extent.width) * extent.height;
+
+    EM_LOG_INFO(
+        "GPU stats, last frame / average of {0}: groups {1}/{2}, vertices {3}/{4}, primitives {5}/{6}, "
+        "VS invocations {7}/{8}, clipped primitives {9}/{10}, FS invocations {11}/{12}, samples passed {13}/{14}",
+        LlyPipelineStatistics::AVERAGE_FRAMES,
+        last.groups, average.groups,
+        last.inputVertices, average.inputVertices,
+        last.inputPrimitives, average.inputPrimitives,
+        last.vertexInvocations, average.vertexInvocations,
+        last.clippingPrimitives, average.clippingPrimitives,
+        last.fragmentInvocations, average.fragmentInvocations,
+        last.samplesPassed, average.samplesPassed);
+    // Shaded fragments per pixel of the framebuffer, and per sample that
+    // survived the depth test
+    EM_LOG_INFO(
+        "GPU overdraw: {0:.2f} fragments per pixel, {1:.2f} fragments per visible sample",
+        average.fragmentInvocations / pixels,
+        average.samplesPassed ? static_cast<double>(average.fragmentInvocations) / average.samplesPassed : 0.0);
+}
+
 } // namespace ember
@@ -1,16 +1,25 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <string>
 
+#include "Allocators.hpp"
 #include "Asserts.hpp"
 #include "Defines.hpp"
+#include "FrameStats.hpp"
 #include "Vulkan/LlyWindow.hpp"
 #include "Events/ApplicationEvent.hpp"
+#include "Events/EventHandlerTable.hpp"
 #include "Events/KeyEvent.hpp"
 #include "Events/MouseEvent.hpp"
+#include "Vulkan/LlyAssetStreamer.hpp"
+#include "Vulkan/LlyCommandRecorder.hpp"
 #include "Vulkan/LlyDevice.hpp"
+#include "Vulkan/LlyGpuProfiler.hpp"
 #include "Vulkan/LlyPipeline.hpp"
+#include "Vulkan/LlyPipelineStatistics.hpp"
+#include "Vulkan/LlyRenderQueue.hpp"
 #include "Vulkan/LlySwapChain.hpp"
 #include "GameObject.hpp"
 
@@ -25,6 +34,38 @@ public:
         unsigned short width;
         unsigned short height;
         std::string title;
+        // Mouse moves and scrolls queued within a frame are merged into one
+        // event, set to receive every raw cursor sample instead
+        bool rawMouseEvents;
+        LoggerConfig logging;
+        // Capture this many frames from the start into profile_capture.json
+        // (Chrome trace format). Needs a build with EM_ENABLE_PROFILER.
+        uint32_t profileCaptureFrames;
+        // Count vertices, shader invocations and samples passed per draw
+        // group with GPU queries, the averages are logged every few frames
+        bool pipelineStatistics;
+        // Seconds between two frame stats reports, 0 means every 10 s. The
+        // whole run is reported on exit either way.
+        float statsReportSeconds;
+        // Render into offscreen images instead of a window, nothing needs a
+        // display or a surface. Run until frameLimit or until stopped.
+        bool headless;
+        // Stop after this many frames, 0 runs until closed
+        uint32_t frameLimit;
+        // Job system workers including the main thread, 0 means one per
+        // hardware thread
+        uint32_t workerThreads;
+        // Pin worker n to logical processor n
+        bool pinWorkerThreads;
+        // Bytes of the per frame linear allocator, 0 means 4 MB
+        uint32_t frameAllocatorSize;
+        // Log the memory report with every frame stats report. It's always
+        // logged on exit.
+        bool memoryReports;
+        // Threads reading streamed assets, 0 means one
+        uint32_t streamingThreads;
+        // Bytes of the asset streaming staging ring, 0 means 32 MB
+        uint32_t streamingBufferSize;
     };
 
     struct ApplicationState
@@ -51,9 +92,43 @@ public:
     virtual bool OnMouseMoved(MouseMovedEvent& e);
     virtual bool OnMouseScrolled(MouseScrolledEvent& e);
 
+    // Draw sorting stats of the last recorded frame
+    inline const LlyRenderQueue::Stats& GetRenderStats() const { return renderQueue_.getStats(); }
+    // Issued and elided command counts of the last recorded frame
+    inline const LlyCommandRecorder::Stats& GetCommandStats() const { return commandRecorder_.getStats(); }
+    // Null unless ApplicationConfig::pipelineStatistics is set
+    inline const LlyPipelineStatistics* GetPipelineStatistics() const { return pipelineStats_.get(); }
+    // Frame time percentiles of the current report window and the whole run
+    inline const FrameStats& GetFrameStats() const { return *frameStats_; }
+
+    // Main thread memory that lives until the start of the next frame,
+    // reset before any of the frame's work runs
+    inline LinearAllocator& GetFrameAllocator() { return *frameAllocator_; }
+
+    // Logs live and peak memory per tag and the device heaps against their
+    // budget
+    void LogMemoryReport() const;
+
+    // Scene access for tools driving the application, e.g. benchmarks
+    inline std::shared_ptr<LlyDevice> GetDevice() const { return device_; }
+    inline std::vector<GameObject>& GetGameObjects() { return gameObjects_; }
+    // Loads models in the background, a streamed model can be given to a
+    // game object once it's ready
+    inline LlyAssetStreamer& GetAssetStreamer() { return *assetStreamer_; }
+    // A pipeline with the default config for models stored in format, built
+    // against the current render pass and pipeline layout. Every format
+    // runs the same shaders, vertex fetch converts to float. Drawing a model
+    // stored in another format with it throws.
+    std::shared_ptr<LlyPipeline> CreatePipeline(VertexFormat format = VertexFormat::Float);
+
+    // Headless only: the last rendered frame as tightly packed RGBA8 rows.
+    // Waits for the GPU to finish. Returns false with a window.
+    bool ReadLastFrame(std::vector<uint8_t>& rgba, uint32_t& width, uint32_t& height);
+
 private:
     static bool initialized;
 
+    void registerEventHandlers();
     void loadGameObjects();
     void createPipelineLayout();
     void createPipeline();
@@ -62,19 +137,39 @@ private:
     void drawFrame();
     void recreateSwapChain();
     void recordCommandBuffer(int imageIndex);
-    void renderGameObjects(VkCommandBuffer commandBuffer);
+    void renderGameObjects(LlyCommandRecorder& recorder);
+    void logPipelineStatistics();
+    void recordFrameStats(uint64_t frameTicks);
 
     bool minimized_;
+    uint64_t frameIndex_ = 0;
+    uint64_t loggedStatsFrames_ = 0;
+    uint64_t lastFrameTicks_ = 0;
+    uint64_t gpuFramesRecorded_ = 0;
 
     ApplicationConfig config_;
     ApplicationState state_;
+    // Histograms are a few KB each, kept off the stack
+    std::unique_ptr<FrameStats> frameStats_;
+    std::unique_ptr<LinearAllocator> frameAllocator_;
+    uint32_t frameAllocatorOverflows_ = 0;
+    // Handlers are member function thunks registered once, the virtual
+    // On* overrides still get called through them
+    EventHandlerTable eventHandlers_;
     std::shared_ptr<LlyWindow> window_;
     std::shared_ptr<LlyDevice> device_;
     std::unique_ptr<LlySwapChain> swapChain_;
-    std::shared_ptr<LlyPipeline> pipeline_;
+    std::unique_ptr<LlyAssetStreamer> assetStreamer_;
+    // Only created in profiler builds
+    std::unique_ptr<LlyGpuProfiler> gpuProfiler_;
+    std::unique_ptr<LlyPipelineStatistics> pipelineStats_;
+    // Default pipeline per vertex format
+    std::array<std::shared_ptr<LlyPipeline>, static_cast<size_t>(VertexFormat::Count)> pipelines_;
     VkPipelineLayout pipelineLayout_;
     std::vector<VkCommandBuffer> commandBuffers_;
     std::vector<GameObject> gameObjects_;
+    LlyRenderQueue renderQueue_;
+    LlyCommandRecorder commandRecorder_;
 };
 
 } // namespace ember
@@ -1,7 +1,21 @@
 #pragma once
 
+#include "FlightRecorder.hpp"
 #include "Logger.hpp"
 
+// Asserts are compiled in unless NDEBUG is defined, the same switch that picks
+// the default log level and the validation layers. Defining EM_ENABLE_ASSERTS
+// keeps them in NDEBUG builds too. Compiled out, the condition is not
+// evaluated at all, sizeof only keeps it type checked and its variables used.
+// A failing assert dumps the flight recorder before breaking.
+//
+// Asserts are for invariants of the engine's own code. Failures that depend
+// on the environment (files, allocations, Vulkan results) throw instead, so
+// release builds still stop on them.
+#if !defined(NDEBUG) && !defined(EM_ENABLE_ASSERTS)
+    #define EM_ENABLE_ASSERTS
+#endif
+
 #ifdef EM_ENABLE_ASSERTS
     #ifdef _MSC_VER
         #include <intrin.h>
@@ -10,9 +24,10 @@
         #define debugBreak() __builtin_trap()
     #endif
 
-    #define EM_ASSERT(x, ...) { if(!(x)) { LOG_ERROR("Assertion failed: {0}", __VA_ARGS__); debugBreak(); } }
-    #define EM_CORE_ASSERT(x, ...) { if(!(x)) { EM_LOG_ERROR("Assertion failed: {0}", __VA_ARGS__); debugBreak(); } }
+    #define EM_ASSERT(x, ...) { if(EM_UNLIKELY(!(x))) { LOG_ERROR("Assertion failed: {0}", __VA_ARGS__); EM_FLIGHT_RECORDER_DUMP(); debugBreak(); } }
+    #define EM_CORE_ASSERT(x, ...) { if(EM_UNLIKELY(!(x))) { EM_LOG_ERROR("Assertion failed: {0}", __VA_ARGS__); EM_FLIGHT_RECORDER_DUMP(); debugBreak(); } }
 #else 
-    #define ASSERT(x, ...)
-    #define EM_ASSERT(x, ...)
-#endif
\ No newline at end of file
+    #define ASSERT(x, ...) ((void)sizeof(!(x)))
+    #define EM_ASSERT(x, ...) ((void)sizeof(!(x)))
+    #define EM_CORE_ASSERT(x, ...) ((void)sizeof(!(x)))
+#endif
@@ -0,0 +1,261 @@
+#include "AsyncLogSink.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace ember
+{
+
+// Upper bound on how long a queued message waits when its producer didn't
+// see the worker going to sleep
+static constexpr auto WORKER_IDLE_TIMEOUT = std::chrono::milliseconds(10);
+
+static size_t RoundUpToPowerOf2(uint32_t value)
+{
+    size_t size = 2;
+    while (size < value)
+        size <<= 1;
+    return size;
+}
+
+AsyncLogSink::AsyncLogSink(
+    std::shared_ptr<spdlog::sinks::sink> target,
+    uint32_t queueSize,
+    LogOverflowPolicy overflowPolicy)
+    : target_(std::move(target)),
+      overflowPolicy_(overflowPolicy)
+{
+    const size_t capacity = RoundUpToPowerOf2(queueSize);
+    mask_ = capacity - 1;
+    slots_ = std::make_unique<Slot[]>(capacity);
+    MemoryTracker::RecordAllocation(MemoryDomain::Cpu, MemoryTag::Logging, capacity * sizeof(Slot));
+    for (size_t i = 0; i < capacity; i++) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    running_.store(true, std::memory_order_release);
+    worker_ = std::thread([this]() { workerLoop(); });
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+    stop();
+    MemoryTracker::RecordFree(MemoryDomain::Cpu, MemoryTag::Logging, (mask_ + 1) * sizeof(Slot));
+}
+
+template<typename F>
+bool AsyncLogSink::tryPush(F&& fill)
+{
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;) {
+        slot = &slots_[pos & mask_];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            // Slot still holds the message from one lap ago, queue is full
+            return false;
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    fill(slot->record);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template<typename F>
+bool AsyncLogSink::tryPop(F&& consume)
+{
+    size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;) {
+        slot = &slots_[pos & mask_];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+        if (diff == 0) {
+            if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = dequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    consume(slot->record);
+    slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    completed_.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void AsyncLogSink::log(const spdlog::details::log_msg& msg)
+{
+    if (!running_.load(std::memory_order_acquire)) {
+        target_->log(msg);
+        return;
+    }
+
+    enqueue(msg);
+}
+
+void AsyncLogSink::enqueue(const spdlog::details::log_msg& msg)
+{
+    const size_t payloadSize = std::min(msg.payload.size(), MAX_PAYLOAD_SIZE);
+    if (payloadSize < msg.payload.size())
+        truncated_.fetch_add(1, std::memory_order_relaxed);
+
+    auto fill = [&](Record& record) {
+        record.time = msg.time;
+        record.source = msg.source;
+        record.loggerName = msg.logger_name;
+        record.threadId = msg.thread_id;
+        record.level = msg.level;
+        record.payloadSize = static_cast<uint32_t>(payloadSize);
+        std::memcpy(record.payload, msg.payload.data(), payloadSize);
+    };
+
+    bool waited = false;
+    while (!tryPush(fill)) {
+        switch (overflowPolicy_) {
+        case LogOverflowPolicy::Drop:
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        case LogOverflowPolicy::OverwriteOldest:
+            // The queue is multi-consumer safe, so the producer can retire
+            // the oldest message itself
+            if (tryPop([](Record&) {}))
+                overwritten_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case LogOverflowPolicy::Block:
+            // Nobody is left to make room
+            if (!running_.load(std::memory_order_acquire)) {
+                target_->log(msg);
+                return;
+            }
+            if (!waited) {
+                waited = true;
+                blocked_.fetch_add(1, std::memory_order_relaxed);
+            }
+            wakeWorker();
+            std::this_thread::yield();
+            break;
+        }
+    }
+
+    enqueued_.fetch_add(1, std::memory_order_relaxed);
+    wakeWorker();
+}
+
+void AsyncLogSink::flush()
+{
+    if (running_.load(std::memory_order_acquire)) {
+        const size_t target = enqueuePos_.load(std::memory_order_acquire);
+        while (completed_.load(std::memory_order_acquire) < target && running_.load(std::memory_order_acquire)) {
+            wakeWorker();
+            std::this_thread::yield();
+        }
+    }
+
+    target_->flush();
+}
+
+void AsyncLogSink::set_pattern(const std::string& pattern)
+{
+    target_->set_pattern(pattern);
+}
+
+void AsyncLogSink::set_formatter(std::unique_ptr<spdlog::formatter> formatter)
+{
+    target_->set_formatter(std::move(formatter));
+}
+
+void AsyncLogSink::stop()
+{
+    if (!running_.exchange(false, std::memory_order_acq_rel))
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        wakeCondition_.notify_one();
+    }
+    worker_.join();
+
+    // Messages from producers that raced with the stop
+    while (tryPop([this](Record& record) { write(record); })) {}
+    target_->flush();
+}
+
+AsyncLogStats AsyncLogSink::getStats() const
+{
+    AsyncLogStats stats;
+    stats.enqueued = enqueued_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.overwritten = overwritten_.load(std::memory_order_relaxed);
+    stats.blocked = blocked_.load(std::memory_order_relaxed);
+    stats.truncated = truncated_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AsyncLogSink::write(const Record& record)
+{
+    spdlog::details::log_msg msg(
+        record.time,
+        record.source,
+        record.loggerName,
+        record.level,
+        spdlog::string_view_t(record.payload, record.payloadSize));
+    msg.thread_id = record.threadId;
+
+    target_->log(msg);
+}
+
+void AsyncLogSink::wakeWorker()
+{
+    // Producers only touch the mutex when the worker is actually parked
+    if (workerSleeping_.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        wakeCondition_.notify_one();
+    }
+}
+
+void AsyncLogSink::workerLoop()
+{
+    auto writeRecord = [this](Record& record) { write(record); };
+
+    for (;;) {
+        size_t written = 0;
+        while (tryPop(writeRecord))
+            written++;
+
+        if (written > 0) {
+            target_->flush();
+            continue;
+        }
+
+        // Queue looked empty: exit if stopping, otherwise park. Producers
+        // racing with the sleep are picked up by the timeout at the latest.
+        if (!running_.load(std::memory_order_acquire)) {
+            // Pick up messages pushed between the last drain and the stop
+            if (!tryPop(writeRecord))
+                break;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        workerSleeping_.store(true, std::memory_order_release);
+        wakeCondition_.wait_for(lock, WORKER_IDLE_TIMEOUT);
+        workerSleeping_.store(false, std::memory_order_release);
+    }
+}
+
+} // namespace ember
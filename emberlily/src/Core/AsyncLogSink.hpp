@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Logger.hpp"
+#include "MemoryTracker.hpp"
+
+namespace ember
+{
+
+// spdlog sink that hands messages to a background thread. Log calls only copy
+// the message into a bounded lock-free multi-producer queue, formatting and
+// console I/O happen on the background thread through the wrapped sink.
+class AsyncLogSink : public spdlog::sinks::sink
+{
+public:
+    // Longer messages are truncated
+    static constexpr size_t MAX_PAYLOAD_SIZE = 448;
+
+    AsyncLogSink(std::shared_ptr<spdlog::sinks::sink> target, uint32_t queueSize, LogOverflowPolicy overflowPolicy);
+    ~AsyncLogSink() override;
+
+    // Delete copy contructors
+    AsyncLogSink(const AsyncLogSink&) = delete;
+    AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+    void log(const spdlog::details::log_msg& msg) override;
+    // Blocks until every message logged before the call has been written
+    void flush() override;
+    void set_pattern(const std::string& pattern) override;
+    void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+    // Drains the queue and joins the background thread. Messages logged after
+    // this are written synchronously.
+    void stop();
+
+    AsyncLogStats getStats() const;
+
+private:
+    struct Record
+    {
+        spdlog::log_clock::time_point time;
+        spdlog::source_loc source;
+        // Points at the logger's name, loggers outlive the sink's queue
+        spdlog::string_view_t loggerName;
+        size_t threadId;
+        spdlog::level::level_enum level;
+        uint32_t payloadSize;
+        char payload[MAX_PAYLOAD_SIZE];
+    };
+
+    // Vyukov's bounded queue: each slot's sequence says whether it is free
+    // for the producer at a position or holds data for the consumer
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    template<typename F>
+    bool tryPush(F&& fill);
+    template<typename F>
+    bool tryPop(F&& consume);
+
+    void enqueue(const spdlog::details::log_msg& msg);
+    void write(const Record& record);
+    void wakeWorker();
+    void workerLoop();
+
+    std::shared_ptr<spdlog::sinks::sink> target_;
+    LogOverflowPolicy overflowPolicy_;
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) std::atomic<size_t> dequeuePos_{0};
+    // Slots released by the consumer or by overwriting producers
+    alignas(64) std::atomic<size_t> completed_{0};
+
+    std::atomic<uint64_t> enqueued_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> overwritten_{0};
+    std::atomic<uint64_t> blocked_{0};
+    std::atomic<uint64_t> truncated_{0};
+
+    // Only used to park the worker while the queue is empty
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+    std::atomic<bool> workerSleeping_{false};
+    std::atomic<bool> running_{false};
+    std::thread worker_;
+};
+
+} // namespace ember
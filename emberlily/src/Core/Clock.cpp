@@ -0,0 +1,31 @@
+#include "Clock.hpp"
+
+namespace ember
+{
+
+// Reference points taken at static initialization, the longer the process
+// has been running the more precise the calibration
+static const uint64_t startTicks = Clock::Ticks();
+static const auto startTime = std::chrono::steady_clock::now();
+
+double Clock::TicksPerSecond()
+{
+#ifdef EM_HAS_TSC
+    static const double ticksPerSecond = []() {
+        constexpr auto minimumSpan = std::chrono::milliseconds(20);
+
+        auto now = std::chrono::steady_clock::now();
+        while (now - startTime < minimumSpan)
+            now = std::chrono::steady_clock::now();
+
+        const uint64_t ticks = Clock::Ticks() - startTicks;
+        const std::chrono::duration<double> elapsed = now - startTime;
+        return static_cast<double>(ticks) / elapsed.count();
+    }();
+    return ticksPerSecond;
+#else
+    return 1e9;
+#endif
+}
+
+} // namespace ember
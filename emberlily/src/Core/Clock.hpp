@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "Defines.hpp"
+
+#if defined(_M_X64) || defined(__x86_64__)
+    #define EM_HAS_TSC
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+#endif
+
+namespace ember
+{
+
+// Cheapest monotonic timestamp available: the time stamp counter on x86-64,
+// steady_clock nanoseconds elsewhere. Only differences mean anything, convert
+// them with Clock::TicksToSeconds.
+class Clock
+{
+public:
+    inline static uint64_t Ticks()
+    {
+#ifdef EM_HAS_TSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // Measured against steady_clock the first time it's asked for. That call
+    // may wait a few milliseconds if the process has only just started.
+    static double TicksPerSecond();
+
+    inline static double TicksToSeconds(uint64_t ticks)
+    {
+        return static_cast<double>(ticks) / TicksPerSecond();
+    }
+};
+
+} // namespace ember
@@ -29,3 +29,12 @@
 #endif
 
 #define BIT(x) (1 << x)
+
+// Branch hints for checks that are expected to (not) fail
+#if defined(__GNUC__) || defined(__clang__)
+    #define EM_LIKELY(x) __builtin_expect(!!(x), 1)
+    #define EM_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+    #define EM_LIKELY(x) (x)
+    #define EM_UNLIKELY(x) (x)
+#endif
@@ -0,0 +1,126 @@
+#include "Fiber.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "Asserts.hpp"
+
+#ifdef EM_PLATFORM_WINDOWS
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace ember
+{
+
+#ifdef EM_PLATFORM_WINDOWS
+
+Fiber::Fiber()
+{
+    // A thread can only be converted once, reuse the fiber it already is
+    handle_ = ConvertThreadToFiber(nullptr);
+    if (handle_) {
+        convertedThread_ = true;
+    } else {
+        if (GetLastError() != ERROR_ALREADY_FIBER)
+            throw std::runtime_error("Could not convert the thread to a fiber!");
+        handle_ = GetCurrentFiber();
+    }
+}
+
+Fiber::Fiber(size_t stackSize, EntryFunction entry, void* argument)
+    : stackSize_(stackSize), entry_(entry), argument_(argument)
+{
+    // Windows commits the stack as it grows and keeps a guard page below the
+    // committed part, the whole reserved size is the limit
+    handle_ = CreateFiberEx(0, stackSize, FIBER_FLAG_FLOAT_SWITCH, &Fiber::Start, this);
+    if (!handle_)
+        throw std::runtime_error("Could not create a fiber!");
+}
+
+Fiber::~Fiber()
+{
+    if (convertedThread_)
+        ConvertFiberToThread();
+    else if (entry_ && handle_)
+        DeleteFiber(handle_);
+}
+
+void Fiber::SwitchTo(Fiber& target)
+{
+    SwitchToFiber(target.handle_);
+}
+
+void __stdcall Fiber::Start(void* fiber)
+{
+    auto* self = static_cast<Fiber*>(fiber);
+    self->entry_(self->argument_);
+    EM_CORE_ASSERT(false, "Fiber entry function returned");
+}
+
+#else
+
+Fiber::Fiber()
+{
+    // Filled in by the first switch away from the thread
+}
+
+Fiber::Fiber(size_t stackSize, EntryFunction entry, void* argument)
+    : entry_(entry), argument_(argument)
+{
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    stackSize_ = (stackSize + pageSize - 1) / pageSize * pageSize;
+
+    // Stacks grow down, the guard page goes at the lowest address. Pages are
+    // only backed by memory once the fiber touches them.
+    mappingSize_ = stackSize_ + pageSize;
+    mapping_ = mmap(nullptr, mappingSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw std::runtime_error("Could not map a fiber stack!");
+    }
+
+    // The destructor doesn't run when the constructor throws
+    if (mprotect(mapping_, pageSize, PROT_NONE) != 0 || getcontext(&context_) != 0) {
+        munmap(mapping_, mappingSize_);
+        mapping_ = nullptr;
+        throw std::runtime_error("Could not set up the fiber stack!");
+    }
+    context_.uc_stack.ss_sp = static_cast<char*>(mapping_) + pageSize;
+    context_.uc_stack.ss_size = stackSize_;
+    context_.uc_link = nullptr;
+
+    // makecontext only passes int arguments, the pointer goes in two halves
+    const auto address = reinterpret_cast<uintptr_t>(this);
+    makecontext(
+        &context_,
+        reinterpret_cast<void (*)()>(&Fiber::Start),
+        2,
+        static_cast<unsigned int>(static_cast<uint64_t>(address) >> 32),
+        static_cast<unsigned int>(address & 0xFFFFFFFFu));
+}
+
+Fiber::~Fiber()
+{
+    if (mapping_)
+        munmap(mapping_, mappingSize_);
+}
+
+void Fiber::SwitchTo(Fiber& target)
+{
+    int ok = swapcontext(&context_, &target.context_);
+    EM_CORE_ASSERT(ok == 0, "Could not switch fibers!");
+}
+
+void Fiber::Start(unsigned int high, unsigned int low)
+{
+    auto* self = reinterpret_cast<Fiber*>(static_cast<uintptr_t>((static_cast<uint64_t>(high) << 32) | low));
+    self->entry_(self->argument_);
+    EM_CORE_ASSERT(false, "Fiber entry function returned");
+}
+
+#endif
+
+} // namespace ember
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Defines.hpp"
+
+#ifndef EM_PLATFORM_WINDOWS
+    #include <ucontext.h>
+#endif
+
+namespace ember
+{
+
+// A stack and a saved execution context to switch to and back from. Windows
+// fibers on Windows, ucontext elsewhere. Each switch there also saves the
+// signal mask, which costs a syscall, so fibers are meant for jobs that wait
+// now and then rather than for switching in tight loops.
+//
+// The stack is mapped with an inaccessible guard page below it, a fiber
+// overflowing its stack crashes right away instead of writing over the
+// memory next to it.
+class Fiber
+{
+public:
+    using EntryFunction = void (*)(void* argument);
+
+    // Wraps the calling thread so it can switch to fibers and be switched
+    // back to. Has to be destroyed on the same thread.
+    Fiber();
+    // Starts at entry(argument) the first time it is switched to, entry must
+    // never return. The stack size is rounded up to whole pages.
+    Fiber(size_t stackSize, EntryFunction entry, void* argument);
+    ~Fiber();
+
+    // Delete copy contructors
+    Fiber(const Fiber&) = delete;
+    Fiber& operator=(const Fiber&) = delete;
+
+    // Saves the running context into this fiber and continues target. This
+    // must be the fiber running on the calling thread. Returns once some
+    // thread switches back to this fiber, not necessarily the same one.
+    void SwitchTo(Fiber& target);
+
+    inline size_t GetStackSize() const { return stackSize_; }
+
+private:
+#ifdef EM_PLATFORM_WINDOWS
+    static void __stdcall Start(void* fiber);
+
+    void* handle_ = nullptr;
+    bool convertedThread_ = false;
+#else
+    static void Start(unsigned int high, unsigned int low);
+
+    ucontext_t context_;
+    void* mapping_ = nullptr;
+    size_t mappingSize_ = 0;
+#endif
+    size_t stackSize_ = 0;
+    EntryFunction entry_ = nullptr;
+    void* argument_ = nullptr;
+};
+
+} // namespace ember
@@ -0,0 +1,226 @@
+#include "FiberScheduler.hpp"
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Asserts.hpp"
+#include "Fiber.hpp"
+#include "MemoryTracker.hpp"
+
+namespace ember
+{
+
+bool FiberScheduler::initialized = false;
+
+struct FiberScheduler::Slot
+{
+    enum class State
+    {
+        Free,
+        Running,
+        Waiting,
+        Finished
+    };
+
+    explicit Slot(size_t stackSize)
+        : fiber(stackSize, &FiberScheduler::FiberMain, this)
+    {
+        // The stack is reserved, pages are only committed once touched
+        MemoryTracker::RecordAllocation(MemoryDomain::Cpu, MemoryTag::Jobs, fiber.GetStackSize());
+    }
+
+    ~Slot() { MemoryTracker::RecordFree(MemoryDomain::Cpu, MemoryTag::Jobs, fiber.GetStackSize()); }
+
+    Fiber fiber;
+    Job job;
+    // What the fiber switches back to when it waits or finishes, set every
+    // time it's resumed
+    Fiber* returnTo = nullptr;
+    const JobCounter* waitingOn = nullptr;
+    State state = State::Free;
+    uint32_t index = 0;
+};
+
+namespace
+{
+
+std::vector<std::unique_ptr<FiberScheduler::Slot>> slots;
+
+// Taking a fiber is once per fiber job, a mutex is cheap enough for that
+std::mutex freeMutex;
+std::vector<uint32_t> freeSlots;
+
+// The fiber each thread started on, created the first time the thread
+// resumes a fiber job
+thread_local std::unique_ptr<Fiber> threadFiber;
+thread_local FiberScheduler::Slot* currentSlot = nullptr;
+
+FiberScheduler::Slot* TryAcquire()
+{
+    std::lock_guard<std::mutex> lock(freeMutex);
+    if (freeSlots.empty())
+        return nullptr;
+
+    const uint32_t index = freeSlots.back();
+    freeSlots.pop_back();
+    return slots[index].get();
+}
+
+void Release(FiberScheduler::Slot* slot)
+{
+    slot->state = FiberScheduler::Slot::State::Free;
+
+    std::lock_guard<std::mutex> lock(freeMutex);
+    freeSlots.push_back(slot->index);
+}
+
+} // namespace
+
+void FiberScheduler::Init(uint32_t fiberCount, size_t stackSize)
+{
+    EM_CORE_ASSERT(!initialized, "Fiber scheduler already initialized");
+
+    slots.reserve(fiberCount);
+    freeSlots.reserve(fiberCount);
+    for (uint32_t i = 0; i < fiberCount; i++) {
+        slots.push_back(std::make_unique<Slot>(stackSize));
+        slots.back()->index = i;
+        // Handed out lowest index first
+        freeSlots.push_back(fiberCount - 1 - i);
+    }
+
+    initialized = true;
+}
+
+void FiberScheduler::Shutdown()
+{
+    if (!initialized)
+        return;
+
+    // Fiber jobs still running or waiting are finished by resume jobs in
+    // the job system's queues, help run them until every fiber is back.
+    // The workers have to still be running.
+    while (GetFreeFiberCount() < slots.size()) {
+        if (!JobSystem::TryRunJob())
+            std::this_thread::yield();
+    }
+
+    freeSlots.clear();
+    slots.clear();
+    threadFiber.reset();
+    initialized = false;
+}
+
+// Out of line on purpose: a fiber may continue on another thread after a
+// switch, reading the thread_local through a call keeps the compiler from
+// reusing an address computed on the previous thread
+FiberScheduler::Slot* FiberScheduler::CurrentSlot()
+{
+    return currentSlot;
+}
+
+bool FiberScheduler::IsInFiber()
+{
+    return CurrentSlot() != nullptr;
+}
+
+uint32_t FiberScheduler::GetFreeFiberCount()
+{
+    std::lock_guard<std::mutex> lock(freeMutex);
+    return static_cast<uint32_t>(freeSlots.size());
+}
+
+void FiberScheduler::Submit(const Job& job)
+{
+    if (!initialized) {
+        Job copy = job;
+        copy.invoke(copy);
+        return;
+    }
+
+    Slot* slot = TryAcquire();
+    while (!slot) {
+        // Running jobs is what frees fibers, only yield when there are none
+        if (!JobSystem::TryRunJob())
+            std::this_thread::yield();
+        slot = TryAcquire();
+    }
+
+    slot->job = job;
+    slot->state = Slot::State::Running;
+    if (job.counter)
+        job.counter->value_.fetch_add(1, std::memory_order_relaxed);
+
+    JobSystem::Run([slot]() { FiberScheduler::Resume(slot); });
+}
+
+void FiberScheduler::Resume(Slot* slot)
+{
+    // A fiber job may end up resuming another one while it runs other jobs,
+    // the other one then switches back to it rather than to the thread
+    Slot* previous = CurrentSlot();
+    Fiber* from = nullptr;
+    if (previous) {
+        from = &previous->fiber;
+    } else {
+        if (!threadFiber)
+            threadFiber = std::make_unique<Fiber>();
+        from = threadFiber.get();
+    }
+
+    slot->returnTo = from;
+    slot->state = Slot::State::Running;
+    currentSlot = slot;
+
+    from->SwitchTo(slot->fiber);
+
+    currentSlot = previous;
+
+    // The fiber's context is saved now, it's safe to hand it to other threads
+    if (slot->state == Slot::State::Finished) {
+        Release(slot);
+        return;
+    }
+
+    EM_CORE_ASSERT(slot->state == Slot::State::Waiting, "Fiber switched back while still running");
+    JobSystem::Run([slot]() { FiberScheduler::Resume(slot); }, nullptr, slot->waitingOn);
+}
+
+void FiberScheduler::Wait(const JobCounter& counter)
+{
+    Slot* slot = CurrentSlot();
+    if (!slot) {
+        JobSystem::Wait(counter);
+        return;
+    }
+
+    if (counter.IsDone())
+        return;
+
+    slot->waitingOn = &counter;
+    slot->state = Slot::State::Waiting;
+    slot->fiber.SwitchTo(*slot->returnTo);
+
+    // Back, possibly on another worker
+    slot->waitingOn = nullptr;
+}
+
+void FiberScheduler::FiberMain(void* argument)
+{
+    auto* slot = static_cast<Slot*>(argument);
+
+    // Fibers are reused, each pass runs one job
+    for (;;) {
+        slot->job.invoke(slot->job);
+
+        if (slot->job.counter)
+            slot->job.counter->value_.fetch_sub(1, std::memory_order_release);
+
+        slot->state = Slot::State::Finished;
+        slot->fiber.SwitchTo(*slot->returnTo);
+    }
+}
+
+} // namespace ember
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "JobSystem.hpp"
+
+namespace ember
+{
+
+// Fiber jobs on top of the job system. A fiber job runs on a fiber of its
+// own, so when it waits on a counter it parks the fiber instead of the
+// worker: the worker goes on with other jobs and whichever worker picks the
+// job up again once the counter is done resumes the fiber on its thread.
+//
+// Fibers come from a pool created up front, there can only be that many fiber
+// jobs queued or running at once. Code running in a fiber must not keep
+// thread_local addresses across a Wait, the fiber may come back on another
+// thread (MSVC: compile with /GT).
+class FiberScheduler
+{
+public:
+    static constexpr uint32_t DEFAULT_FIBER_COUNT = 128;
+    static constexpr size_t DEFAULT_STACK_SIZE = 256 * 1024;
+
+    // After JobSystem::Init, on the same thread
+    static void Init(uint32_t fiberCount = DEFAULT_FIBER_COUNT, size_t stackSize = DEFAULT_STACK_SIZE);
+    // Before JobSystem::Shutdown, on the same thread as Init. Helps run jobs
+    // until every fiber job has finished.
+    static void Shutdown();
+
+    static bool IsInitialized() { return initialized; }
+
+    // Same rules as JobSystem::Run. Runs right away when the scheduler isn't
+    // initialized, when every fiber is taken it runs other jobs until one is
+    // free.
+    template<typename F>
+    static void Run(F&& function, JobCounter* counter = nullptr)
+    {
+        Submit(JobSystem::MakeJob(std::forward<F>(function), counter));
+    }
+
+    // In a fiber job, parks the fiber until counter is done. Anywhere else
+    // it's JobSystem::Wait.
+    static void Wait(const JobCounter& counter);
+
+    // Whether the calling code runs in a fiber job
+    static bool IsInFiber();
+
+    // Fibers not running or waiting right now
+    static uint32_t GetFreeFiberCount();
+
+    // A pooled fiber and the job it runs, only defined in the .cpp
+    struct Slot;
+
+private:
+    static void Submit(const Job& job);
+    static void Resume(Slot* slot);
+    static void FiberMain(void* argument);
+    static Slot* CurrentSlot();
+
+    static bool initialized;
+};
+
+} // namespace ember
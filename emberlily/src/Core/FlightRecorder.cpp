@@ -0,0 +1,171 @@
+#include "FlightRecorder.hpp"
+
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace ember
+{
+
+static constexpr char DUMP_MAGIC[4] = {'E', 'M', 'F', 'R'};
+static constexpr uint32_t DUMP_VERSION = 1;
+static constexpr uint32_t MAX_FORMATS = 1024;
+
+namespace
+{
+
+struct FormatInfo
+{
+    const char* file;
+    int line;
+    const char* format;
+};
+
+// Registered call sites. Slots are filled under the mutex and published by
+// bumping the count, the dump reads them without locking.
+FormatInfo formats[MAX_FORMATS];
+std::atomic<uint32_t> formatCount{0};
+std::mutex formatMutex;
+
+std::atomic<uint32_t> threadCount{0};
+std::mutex freeBuffersMutex;
+
+std::string dumpPath = "flight_record.bin";
+std::atomic<bool> dumping{false};
+
+void WriteU32(std::FILE* file, uint32_t value) { std::fwrite(&value, sizeof(value), 1, file); }
+
+void WriteString(std::FILE* file, const char* text)
+{
+    const uint32_t length = static_cast<uint32_t>(std::strlen(text));
+    WriteU32(file, length);
+    std::fwrite(text, 1, length, file);
+}
+
+void OnCrashSignal(int signal)
+{
+    FlightRecorder::Dump();
+
+    // Let the default handler finish the process
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+} // namespace
+
+std::atomic<FlightRecorder::ThreadBuffer*> FlightRecorder::threadBuffers{nullptr};
+FlightRecorder::ThreadBuffer* FlightRecorder::freeBuffers = nullptr;
+
+void FlightRecorder::Init(const std::string& path)
+{
+    dumpPath = path;
+
+    // Writing the file from a signal handler isn't strictly async-signal
+    // safe, but the process is going down anyway and this is the last
+    // chance to get the buffers out
+    std::signal(SIGSEGV, OnCrashSignal);
+    std::signal(SIGABRT, OnCrashSignal);
+    std::signal(SIGFPE, OnCrashSignal);
+    std::signal(SIGILL, OnCrashSignal);
+}
+
+uint32_t FlightRecorder::RegisterFormat(const char* file, int line, const char* format)
+{
+    std::lock_guard<std::mutex> lock(formatMutex);
+
+    const uint32_t id = formatCount.load(std::memory_order_relaxed);
+    if (id == MAX_FORMATS) {
+        // Out of slots, records of this call site decode as unknown
+        return MAX_FORMATS;
+    }
+
+    formats[id] = FormatInfo{file, line, format};
+    formatCount.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+FlightRecorder::ThreadBuffer* FlightRecorder::AcquireThreadBuffer()
+{
+    {
+        std::lock_guard<std::mutex> lock(freeBuffersMutex);
+        if (ThreadBuffer* buffer = freeBuffers) {
+            freeBuffers = buffer->nextFree;
+            return buffer;
+        }
+    }
+
+    auto* buffer = new ThreadBuffer();
+    buffer->threadIndex = threadCount.fetch_add(1, std::memory_order_relaxed);
+
+    ThreadBuffer* head = threadBuffers.load(std::memory_order_relaxed);
+    do {
+        buffer->next = head;
+    } while (!threadBuffers.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+
+    return buffer;
+}
+
+void FlightRecorder::ReleaseThreadBuffer(ThreadBuffer* buffer)
+{
+    std::lock_guard<std::mutex> lock(freeBuffersMutex);
+    buffer->nextFree = freeBuffers;
+    freeBuffers = buffer;
+}
+
+bool FlightRecorder::Dump()
+{
+    return Dump(dumpPath);
+}
+
+bool FlightRecorder::Dump(const std::string& path)
+{
+    // A crash while dumping would otherwise recurse through the handler
+    if (dumping.exchange(true))
+        return false;
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        dumping.store(false);
+        return false;
+    }
+
+    std::fwrite(DUMP_MAGIC, 1, sizeof(DUMP_MAGIC), file);
+    WriteU32(file, DUMP_VERSION);
+    const double ticksPerSecond = Clock::TicksPerSecond();
+    std::fwrite(&ticksPerSecond, sizeof(ticksPerSecond), 1, file);
+
+    const uint32_t count = formatCount.load(std::memory_order_acquire);
+    WriteU32(file, count);
+    for (uint32_t i = 0; i < count; i++) {
+        WriteU32(file, static_cast<uint32_t>(formats[i].line));
+        WriteString(file, formats[i].file);
+        WriteString(file, formats[i].format);
+    }
+
+    ThreadBuffer* first = threadBuffers.load(std::memory_order_acquire);
+    uint32_t buffers = 0;
+    for (ThreadBuffer* buffer = first; buffer; buffer = buffer->next)
+        buffers++;
+
+    WriteU32(file, buffers);
+    for (ThreadBuffer* buffer = first; buffer; buffer = buffer->next) {
+        // Other threads may keep recording while this runs, their newest
+        // records can come out torn. Good enough for a post-mortem.
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const uint64_t recordCount = head < RECORDS_PER_THREAD ? head : RECORDS_PER_THREAD;
+
+        WriteU32(file, buffer->threadIndex);
+        WriteU32(file, static_cast<uint32_t>(recordCount));
+        for (uint64_t i = head - recordCount; i < head; i++) {
+            std::fwrite(&buffer->records[i & (RECORDS_PER_THREAD - 1)], sizeof(Record), 1, file);
+        }
+    }
+
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    dumping.store(false);
+    return ok;
+}
+
+} // namespace ember
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "Clock.hpp"
+
+namespace ember
+{
+
+// Always-on binary trace of what the engine was doing lately. Every thread
+// records into its own ring buffer, a record is a timestamp, the id of a
+// format string registered once per call site and up to three integer
+// arguments. Nothing is formatted at record time.
+//
+// The buffers are written to a file on a failed assert, on a crash signal or
+// when Dump is called, tools/decode_flight_record.py turns that file back
+// into text.
+class FlightRecorder
+{
+public:
+    // Records kept per thread, older ones get overwritten
+    static constexpr uint32_t RECORDS_PER_THREAD = 4096;
+    static_assert((RECORDS_PER_THREAD & (RECORDS_PER_THREAD - 1)) == 0, "Record count must be a power of 2");
+
+    struct Record
+    {
+        uint64_t ticks;
+        uint32_t formatId;
+        uint32_t argCount;
+        uint64_t args[3];
+    };
+    static_assert(sizeof(Record) == 40, "The decoder expects 40 byte records");
+
+    // Sets where Dump writes by default and hooks the crash signals so the
+    // buffers get dumped before the process dies
+    static void Init(const std::string& dumpPath);
+
+    // Returns an id for a format string, "{0}" to "{2}" are replaced by the
+    // record's arguments when decoding. The string must outlive the recorder,
+    // in practice it is a literal.
+    static uint32_t RegisterFormat(const char* file, int line, const char* format);
+
+    template<typename... Args>
+    inline static void Write(uint32_t formatId, Args... args)
+    {
+        static_assert(sizeof...(Args) <= 3, "At most 3 arguments per record");
+
+        ThreadBuffer& buffer = GetThreadBuffer();
+        const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+
+        Record& record = buffer.records[head & (RECORDS_PER_THREAD - 1)];
+        record.ticks = Clock::Ticks();
+        record.formatId = formatId;
+        record.argCount = sizeof...(Args);
+        StoreArgs(record.args, args...);
+
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    // Writes every thread's buffer to the file given to Init, or to path.
+    // Returns false if the file couldn't be written.
+    static bool Dump();
+    static bool Dump(const std::string& path);
+
+private:
+    struct ThreadBuffer
+    {
+        Record records[RECORDS_PER_THREAD];
+        // Total records written, the ring holds the last RECORDS_PER_THREAD
+        std::atomic<uint64_t> head{0};
+        // Kept when the buffer passes to a new thread
+        uint32_t threadIndex = 0;
+        ThreadBuffer* next = nullptr;
+        ThreadBuffer* nextFree = nullptr;
+    };
+
+    // Every buffer ever created. They're never freed, the history of a
+    // thread that already exited still ends up in the dump until the next
+    // new thread takes over its buffer and writes over it.
+    static std::atomic<ThreadBuffer*> threadBuffers;
+    // Buffers of threads that exited, guarded by a mutex in FlightRecorder.cpp
+    static ThreadBuffer* freeBuffers;
+
+    // Gives the buffer back when its thread exits
+    struct ThreadBufferOwner
+    {
+        ThreadBuffer* buffer = AcquireThreadBuffer();
+        ~ThreadBufferOwner() { ReleaseThreadBuffer(buffer); }
+    };
+
+    static ThreadBuffer& GetThreadBuffer()
+    {
+        thread_local ThreadBufferOwner owner;
+        return *owner.buffer;
+    }
+
+    static ThreadBuffer* AcquireThreadBuffer();
+    static void ReleaseThreadBuffer(ThreadBuffer* buffer);
+
+    static void StoreArgs(uint64_t*) {}
+
+    template<typename T, typename... Rest>
+    static void StoreArgs(uint64_t* out, T value, Rest... rest)
+    {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "Records only hold integers");
+        *out = static_cast<uint64_t>(value);
+        StoreArgs(out + 1, rest...);
+    }
+};
+
+} // namespace ember
+
+#ifndef EM_DISABLE_FLIGHT_RECORDER
+    // EM_RECORD("Acquire result {0}", result): a few nanoseconds, the format
+    // string is registered the first time the line runs
+    #define EM_RECORD(format, ...)                                                           \
+        do {                                                                                 \
+            static const uint32_t emFormatId_ =                                              \
+                ::ember::FlightRecorder::RegisterFormat(__FILE__, __LINE__, format);         \
+            ::ember::FlightRecorder::Write(emFormatId_, ##__VA_ARGS__);                      \
+        } while (0)
+    #define EM_FLIGHT_RECORDER_DUMP() ::ember::FlightRecorder::Dump()
+#else
+    #define EM_RECORD(format, ...) ((void)0)
+    #define EM_FLIGHT_RECORDER_DUMP() ((void)0)
+#endif
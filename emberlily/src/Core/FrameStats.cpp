@@ -0,0 +1,200 @@
+#include "FrameStats.hpp"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+#include "Clock.hpp"
+#include "Logger.hpp"
+
+namespace ember
+{
+
+namespace
+{
+
+struct MetricInfo
+{
+    const char* name;
+    const char* unit;
+    // Histograms hold integers, times are recorded in microseconds
+    double scale;
+};
+
+const MetricInfo metricInfos[FrameStats::MetricCount] = {
+    {"frame time", "ms", 1000.0},
+    {"cpu time", "ms", 1000.0},
+    {"gpu time", "ms", 1000.0},
+    {"fence wait", "ms", 1000.0},
+    {"acquire", "ms", 1000.0},
+    {"submit", "ms", 1000.0},
+    {"present", "ms", 1000.0},
+    {"draws", "", 1.0},
+    {"pipeline binds", "", 1.0},
+    {"vertex binds", "", 1.0},
+};
+
+inline uint32_t HighestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return 63u - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+}
+
+} // namespace
+
+Histogram::Histogram()
+    : buckets_(BUCKET_COUNT, 0)
+{
+}
+
+uint32_t Histogram::BucketIndex(uint64_t value)
+{
+    // Small values get a bucket each
+    if (value < SUB_BUCKETS)
+        return static_cast<uint32_t>(value);
+
+    // The bits right below the highest one pick the sub bucket
+    const uint32_t exponent = HighestBit(value);
+    const uint32_t subBucket = static_cast<uint32_t>(value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket;
+}
+
+uint64_t Histogram::BucketLowest(uint32_t index)
+{
+    if (index < SUB_BUCKETS)
+        return index;
+
+    const uint32_t exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    const uint64_t subBucket = index % SUB_BUCKETS;
+    return (SUB_BUCKETS + subBucket) << (exponent - SUB_BUCKET_BITS);
+}
+
+uint64_t Histogram::BucketWidth(uint32_t index)
+{
+    if (index < SUB_BUCKETS)
+        return 1;
+
+    const uint32_t exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    return 1ull << (exponent - SUB_BUCKET_BITS);
+}
+
+void Histogram::Record(uint64_t value)
+{
+    buckets_[BucketIndex(value)]++;
+    count_++;
+    sum_ += value;
+    max_ = value > max_ ? value : max_;
+}
+
+void Histogram::Reset()
+{
+    std::fill(buckets_.begin(), buckets_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+}
+
+uint64_t Histogram::ValueAtPercentile(double percentile) const
+{
+    if (count_ == 0)
+        return 0;
+
+    // Rank of the value, 1 based
+    uint64_t rank = static_cast<uint64_t>(percentile * count_ + 0.5);
+    rank = rank < 1 ? 1 : (rank > count_ ? count_ : rank);
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            const uint64_t middle = BucketLowest(i) + BucketWidth(i) / 2;
+            return middle < max_ ? middle : max_;
+        }
+    }
+    return max_;
+}
+
+FrameStats::FrameStats(double reportIntervalSeconds)
+{
+    reportIntervalTicks_ = static_cast<uint64_t>(reportIntervalSeconds * Clock::TicksPerSecond());
+    windowStartTicks_ = Clock::Ticks();
+    runStartTicks_ = windowStartTicks_;
+}
+
+void FrameStats::Record(Metric metric, double value)
+{
+    const double scaled = value * metricInfos[metric].scale;
+    const uint64_t units = scaled > 0.0 ? static_cast<uint64_t>(scaled + 0.5) : 0;
+
+    window_[metric].Record(units);
+    total_[metric].Record(units);
+}
+
+bool FrameStats::EndFrame()
+{
+    const uint64_t now = Clock::Ticks();
+    if (now - windowStartTicks_ < reportIntervalTicks_)
+        return false;
+
+    Log("Frame stats", Clock::TicksToSeconds(now - windowStartTicks_), window_);
+
+    for (auto& histogram : window_)
+        histogram.Reset();
+    windowStartTicks_ = now;
+    return true;
+}
+
+void FrameStats::LogWindow() const
+{
+    Log("Frame stats", Clock::TicksToSeconds(Clock::Ticks() - windowStartTicks_), window_);
+}
+
+void FrameStats::LogTotal() const
+{
+    Log("Frame stats for the whole run", Clock::TicksToSeconds(Clock::Ticks() - runStartTicks_), total_);
+}
+
+FrameStats::Summary FrameStats::Summarize(Metric metric, const Histogram& histogram)
+{
+    const double scale = metricInfos[metric].scale;
+
+    Summary summary;
+    summary.count = histogram.GetCount();
+    summary.mean = histogram.GetMean() / scale;
+    summary.p50 = histogram.ValueAtPercentile(0.50) / scale;
+    summary.p95 = histogram.ValueAtPercentile(0.95) / scale;
+    summary.p99 = histogram.ValueAtPercentile(0.99) / scale;
+    summary.max = histogram.GetMax() / scale;
+    return summary;
+}
+
+void FrameStats::Log(const char* title, double seconds, const std::array<Histogram, MetricCount>& histograms)
+{
+    EM_LOG_INFO("{0}, {1:.1f} s over {2} frames:", title, seconds, histograms[FrameTime].GetCount());
+
+    for (uint32_t i = 0; i < MetricCount; i++) {
+        const auto metric = static_cast<Metric>(i);
+        if (histograms[metric].GetCount() == 0)
+            continue;
+
+        const Summary summary = Summarize(metric, histograms[metric]);
+        EM_LOG_INFO(
+            "  {0:<15} mean {1:9.3f}  p50 {2:9.3f}  p95 {3:9.3f}  p99 {4:9.3f}  max {5:9.3f} {6}",
+            metricInfos[metric].name,
+            summary.mean,
+            summary.p50,
+            summary.p95,
+            summary.p99,
+            summary.max,
+            metricInfos[metric].unit);
+    }
+}
+
+} // namespace ember
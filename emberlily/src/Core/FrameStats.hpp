@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace ember
+{
+
+// Fixed-size log-linear histogram of unsigned values. Every power of two is
+// split into 16 buckets, so a percentile is off by at most 1/16 of its value
+// while recording stays a couple of shifts and an increment.
+class Histogram
+{
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 4;
+    static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr uint32_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    Histogram();
+
+    void Record(uint64_t value);
+    void Reset();
+
+    // Midpoint of the bucket holding the value at percentile, in [0, 1]
+    uint64_t ValueAtPercentile(double percentile) const;
+
+    inline uint64_t GetCount() const { return count_; }
+    inline uint64_t GetMax() const { return max_; }
+    inline double GetMean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+private:
+    static uint32_t BucketIndex(uint64_t value);
+    static uint64_t BucketLowest(uint32_t index);
+    static uint64_t BucketWidth(uint32_t index);
+
+    std::vector<uint32_t> buckets_;
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
+
+// Per frame timings and counts, kept in histograms so hitches show up in the
+// tail percentiles instead of disappearing into an average. Every report
+// interval the window is logged and started over; a second set of histograms
+// covers the whole run and is logged on exit.
+class FrameStats
+{
+public:
+    enum Metric : uint32_t
+    {
+        FrameTime,          // ms between the start of two frames
+        CpuTime,            // ms of frame work not spent blocked on fences or acquire
+        GpuTime,            // ms, top level GPU profiler scopes, a few frames late
+        FenceWait,          // ms
+        Acquire,            // ms
+        Submit,             // ms
+        Present,            // ms
+        Draws,
+        PipelineBinds,
+        VertexBufferBinds,
+        MetricCount
+    };
+
+    struct Summary
+    {
+        uint64_t count;
+        double mean;
+        double p50;
+        double p95;
+        double p99;
+        double max;
+    };
+
+    explicit FrameStats(double reportIntervalSeconds = 10.0);
+
+    // Times in milliseconds, anything finer than a microsecond is dropped
+    void Record(Metric metric, double value);
+    // Logs and restarts the window once the report interval has passed,
+    // returns true on those frames
+    bool EndFrame();
+
+    Summary GetWindowSummary(Metric metric) const { return Summarize(metric, window_[metric]); }
+    Summary GetTotalSummary(Metric metric) const { return Summarize(metric, total_[metric]); }
+
+    void LogWindow() const;
+    void LogTotal() const;
+
+private:
+    static Summary Summarize(Metric metric, const Histogram& histogram);
+    static void Log(const char* title, double seconds, const std::array<Histogram, MetricCount>& histograms);
+
+    std::array<Histogram, MetricCount> window_;
+    std::array<Histogram, MetricCount> total_;
+
+    uint64_t reportIntervalTicks_;
+    uint64_t windowStartTicks_;
+    uint64_t runStartTicks_;
+};
+
+} // namespace ember
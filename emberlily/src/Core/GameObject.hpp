@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "Vulkan/LlyModel.hpp"
+#include "Vulkan/LlyPipeline.hpp"
 
 namespace ember
 {
@@ -40,8 +41,13 @@ public:
     id_t getId() { return id_; }
 
     std::shared_ptr<LlyModel> model{};
+    // Null draws with the application's default pipeline for the model's
+    // vertex format, otherwise it has to read that format
+    std::shared_ptr<LlyPipeline> pipeline{};
     glm::vec3 color{};
     Transform2dComponent transform2d;
+    // Objects in lower layers are drawn first
+    uint8_t layer{0};
 
 private:
     GameObject(id_t objId) : id_{objId} {}
@@ -0,0 +1,197 @@
+#include "Input.hpp"
+
+#include <cstring>
+
+#include "Events/KeyEvent.hpp"
+#include "Events/MouseEvent.hpp"
+
+namespace ember
+{
+
+Input::Snapshot Input::live;
+Input::SharedState Input::shared;
+
+static uint64_t PackFloats(float x, float y)
+{
+    uint32_t xBits, yBits;
+    std::memcpy(&xBits, &x, sizeof(float));
+    std::memcpy(&yBits, &y, sizeof(float));
+    return (static_cast<uint64_t>(yBits) << 32) | xBits;
+}
+
+static void UnpackFloats(uint64_t packed, float& x, float& y)
+{
+    const uint32_t xBits = static_cast<uint32_t>(packed);
+    const uint32_t yBits = static_cast<uint32_t>(packed >> 32);
+    std::memcpy(&x, &xBits, sizeof(float));
+    std::memcpy(&y, &yBits, sizeof(float));
+}
+
+static void SetKey(Input::Snapshot& state, KeyCode key, bool down)
+{
+    const uint32_t index = static_cast<uint32_t>(key);
+    // GLFW reports unknown keys as -1
+    if (index >= Input::KEY_COUNT)
+        return;
+
+    const uint64_t bit = 1ull << (index % 64);
+    uint64_t& word = state.keysDown[index / 64];
+    if (down) {
+        word |= bit;
+        state.keysPressed[index / 64] |= bit;
+    } else {
+        word &= ~bit;
+        state.keysReleased[index / 64] |= bit;
+    }
+}
+
+static void SetButton(Input::Snapshot& state, int button, bool down)
+{
+    if (button < 0 || button >= static_cast<int>(Input::MOUSE_BUTTON_COUNT))
+        return;
+
+    const uint32_t bit = 1u << button;
+    if (down) {
+        state.buttonsDown |= bit;
+        state.buttonsPressed |= bit;
+    } else {
+        state.buttonsDown &= ~bit;
+        state.buttonsReleased |= bit;
+    }
+}
+
+void Input::OnEvent(const Event& e)
+{
+    switch (e.GetEventType())
+    {
+    case EventType::KeyPressed:
+        SetKey(live, static_cast<const KeyEvent&>(e).GetKeyCode(), true);
+        break;
+    case EventType::KeyReleased:
+        SetKey(live, static_cast<const KeyEvent&>(e).GetKeyCode(), false);
+        break;
+    case EventType::MouseButtonPressed:
+        SetButton(live, static_cast<const MouseButtonEvent&>(e).GetMouseButton(), true);
+        break;
+    case EventType::MouseButtonReleased:
+        SetButton(live, static_cast<const MouseButtonEvent&>(e).GetMouseButton(), false);
+        break;
+    case EventType::MouseMoved:
+    {
+        const auto& moved = static_cast<const MouseMovedEvent&>(e);
+        live.cursorX = moved.GetX();
+        live.cursorY = moved.GetY();
+        break;
+    }
+    case EventType::MouseScrolled:
+    {
+        const auto& scrolled = static_cast<const MouseScrolledEvent&>(e);
+        live.scrollX += scrolled.GetXOffset();
+        live.scrollY += scrolled.GetYOffset();
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void Input::Publish()
+{
+    live.frame++;
+
+    // Odd sequence while writing, readers of a whole snapshot retry until it
+    // is even and unchanged across their reads
+    const uint32_t sequence = shared.sequence.load(std::memory_order_relaxed);
+    shared.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (uint32_t i = 0; i < KEY_WORDS; i++) {
+        shared.keysDown[i].store(live.keysDown[i], std::memory_order_relaxed);
+        shared.keysPressed[i].store(live.keysPressed[i], std::memory_order_relaxed);
+        shared.keysReleased[i].store(live.keysReleased[i], std::memory_order_relaxed);
+    }
+    shared.buttonsDown.store(live.buttonsDown, std::memory_order_relaxed);
+    shared.buttonsPressed.store(live.buttonsPressed, std::memory_order_relaxed);
+    shared.buttonsReleased.store(live.buttonsReleased, std::memory_order_relaxed);
+    shared.cursor.store(PackFloats(live.cursorX, live.cursorY), std::memory_order_relaxed);
+    shared.scroll.store(PackFloats(live.scrollX, live.scrollY), std::memory_order_relaxed);
+    shared.frame.store(live.frame, std::memory_order_relaxed);
+
+    shared.sequence.store(sequence + 2, std::memory_order_release);
+
+    // Edges and scroll only cover the frame they happened in
+    live.keysPressed.fill(0);
+    live.keysReleased.fill(0);
+    live.buttonsPressed = 0;
+    live.buttonsReleased = 0;
+    live.scrollX = 0.0f;
+    live.scrollY = 0.0f;
+}
+
+static bool TestKeyWord(const std::atomic<uint64_t>* words, KeyCode key)
+{
+    const uint32_t index = static_cast<uint32_t>(key);
+    if (index >= Input::KEY_COUNT)
+        return false;
+
+    return (words[index / 64].load(std::memory_order_relaxed) >> (index % 64)) & 1;
+}
+
+static bool TestButtonWord(const std::atomic<uint32_t>& word, int button)
+{
+    if (button < 0 || button >= static_cast<int>(Input::MOUSE_BUTTON_COUNT))
+        return false;
+
+    return (word.load(std::memory_order_relaxed) >> button) & 1;
+}
+
+bool Input::IsKeyDown(KeyCode key) { return TestKeyWord(shared.keysDown.data(), key); }
+bool Input::IsKeyPressed(KeyCode key) { return TestKeyWord(shared.keysPressed.data(), key); }
+bool Input::IsKeyReleased(KeyCode key) { return TestKeyWord(shared.keysReleased.data(), key); }
+bool Input::IsMouseButtonDown(int button) { return TestButtonWord(shared.buttonsDown, button); }
+bool Input::IsMouseButtonPressed(int button) { return TestButtonWord(shared.buttonsPressed, button); }
+bool Input::IsMouseButtonReleased(int button) { return TestButtonWord(shared.buttonsReleased, button); }
+
+void Input::GetCursorPosition(float& x, float& y)
+{
+    UnpackFloats(shared.cursor.load(std::memory_order_relaxed), x, y);
+}
+
+void Input::GetScroll(float& x, float& y)
+{
+    UnpackFloats(shared.scroll.load(std::memory_order_relaxed), x, y);
+}
+
+uint64_t Input::GetFrame()
+{
+    return shared.frame.load(std::memory_order_relaxed);
+}
+
+Input::Snapshot Input::GetSnapshot()
+{
+    Snapshot snapshot;
+    uint32_t before, after;
+
+    do {
+        before = shared.sequence.load(std::memory_order_acquire);
+
+        for (uint32_t i = 0; i < KEY_WORDS; i++) {
+            snapshot.keysDown[i] = shared.keysDown[i].load(std::memory_order_relaxed);
+            snapshot.keysPressed[i] = shared.keysPressed[i].load(std::memory_order_relaxed);
+            snapshot.keysReleased[i] = shared.keysReleased[i].load(std::memory_order_relaxed);
+        }
+        snapshot.buttonsDown = shared.buttonsDown.load(std::memory_order_relaxed);
+        snapshot.buttonsPressed = shared.buttonsPressed.load(std::memory_order_relaxed);
+        snapshot.buttonsReleased = shared.buttonsReleased.load(std::memory_order_relaxed);
+        UnpackFloats(shared.cursor.load(std::memory_order_relaxed), snapshot.cursorX, snapshot.cursorY);
+        UnpackFloats(shared.scroll.load(std::memory_order_relaxed), snapshot.scrollX, snapshot.scrollY);
+        snapshot.frame = shared.frame.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = shared.sequence.load(std::memory_order_relaxed);
+    } while (before != after || (before & 1));
+
+    return snapshot;
+}
+
+} // namespace ember
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "KeyCode.hpp"
+#include "Events/Event.hpp"
+
+namespace ember
+{
+
+// Polled view of the keyboard and mouse. The main thread feeds window events
+// into a live state while draining the event queue, then publishes it once
+// per frame. Queries only ever see the published frame, so "pressed this
+// frame" is stable for the whole frame and can be read from any thread
+// without taking a lock.
+class Input
+{
+public:
+    // Covers every GLFW key code (highest is Menu = 348)
+    static constexpr uint32_t KEY_COUNT = 512;
+    static constexpr uint32_t KEY_WORDS = KEY_COUNT / 64;
+    static constexpr uint32_t MOUSE_BUTTON_COUNT = 8;
+
+    // Consistent copy of one published frame
+    struct Snapshot
+    {
+        std::array<uint64_t, KEY_WORDS> keysDown{};
+        std::array<uint64_t, KEY_WORDS> keysPressed{};
+        std::array<uint64_t, KEY_WORDS> keysReleased{};
+        uint32_t buttonsDown = 0;
+        uint32_t buttonsPressed = 0;
+        uint32_t buttonsReleased = 0;
+        float cursorX = 0.0f;
+        float cursorY = 0.0f;
+        // Scroll offsets accumulated over the frame
+        float scrollX = 0.0f;
+        float scrollY = 0.0f;
+        uint64_t frame = 0;
+
+        inline bool IsKeyDown(KeyCode key) const { return TestKey(keysDown, key); }
+        inline bool IsKeyPressed(KeyCode key) const { return TestKey(keysPressed, key); }
+        inline bool IsKeyReleased(KeyCode key) const { return TestKey(keysReleased, key); }
+        inline bool IsMouseButtonDown(int button) const { return TestButton(buttonsDown, button); }
+        inline bool IsMouseButtonPressed(int button) const { return TestButton(buttonsPressed, button); }
+        inline bool IsMouseButtonReleased(int button) const { return TestButton(buttonsReleased, button); }
+    };
+
+    // Main thread only: update the live state from a window event
+    static void OnEvent(const Event& e);
+    // Main thread only: make the live state visible to queries and start
+    // collecting the next frame's pressed/released edges
+    static void Publish();
+
+    // Safe from any thread. Each of these is a single atomic load.
+    static bool IsKeyDown(KeyCode key);
+    static bool IsKeyPressed(KeyCode key);
+    static bool IsKeyReleased(KeyCode key);
+    static bool IsMouseButtonDown(int button);
+    static bool IsMouseButtonPressed(int button);
+    static bool IsMouseButtonReleased(int button);
+    static void GetCursorPosition(float& x, float& y);
+    static void GetScroll(float& x, float& y);
+    // Number of frames published so far
+    static uint64_t GetFrame();
+
+    // Safe from any thread. Retries while a publish is in progress so every
+    // field comes from the same frame.
+    static Snapshot GetSnapshot();
+
+private:
+    static inline bool TestKey(const std::array<uint64_t, KEY_WORDS>& bits, KeyCode key)
+    {
+        const uint32_t index = static_cast<uint32_t>(key);
+        return index < KEY_COUNT && (bits[index / 64] >> (index % 64)) & 1;
+    }
+
+    static inline bool TestButton(uint32_t bits, int button)
+    {
+        return button >= 0 && button < static_cast<int>(MOUSE_BUTTON_COUNT) && (bits >> button) & 1;
+    }
+
+    // Published frame. Every field is its own atomic so single queries never
+    // tear, the sequence counter makes whole snapshots consistent.
+    struct SharedState
+    {
+        std::atomic<uint32_t> sequence{0};
+        std::array<std::atomic<uint64_t>, KEY_WORDS> keysDown{};
+        std::array<std::atomic<uint64_t>, KEY_WORDS> keysPressed{};
+        std::array<std::atomic<uint64_t>, KEY_WORDS> keysReleased{};
+        std::atomic<uint32_t> buttonsDown{0};
+        std::atomic<uint32_t> buttonsPressed{0};
+        std::atomic<uint32_t> buttonsReleased{0};
+        // x and y float bits packed into one word
+        std::atomic<uint64_t> cursor{0};
+        std::atomic<uint64_t> scroll{0};
+        std::atomic<uint64_t> frame{0};
+    };
+
+    static Snapshot live;
+    static SharedState shared;
+};
+
+} // namespace ember
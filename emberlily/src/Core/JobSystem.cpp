@@ -0,0 +1,375 @@
+#include "JobSystem.hpp"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Asserts.hpp"
+#include "Defines.hpp"
+#include "MemoryTracker.hpp"
+
+#ifdef EM_PLATFORM_WINDOWS
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace ember
+{
+
+uint32_t JobSystem::workerCount = 0;
+
+namespace
+{
+
+// Chase-Lev deque with a fixed capacity, as in "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (Le et al.). Push and Pop are called
+// by the owning worker only, Steal by anyone.
+class JobDeque
+{
+public:
+    static constexpr int64_t CAPACITY = JobSystem::MAX_JOBS_PER_WORKER;
+
+    bool Push(Job* job)
+    {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const int64_t top = top_.load(std::memory_order_acquire);
+        if (bottom - top >= CAPACITY)
+            return false;
+
+        // Release so a thief loading the slot also sees the job it points to
+        slots_[bottom & (CAPACITY - 1)].store(job, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    Job* Pop()
+    {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            // Empty
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job* job = slots_[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // Last job, race the thieves for it
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = nullptr;
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    Job* Steal()
+    {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom)
+            return nullptr;
+
+        Job* job = slots_[top & (CAPACITY - 1)].load(std::memory_order_acquire);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return job;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<Job*> slots_[CAPACITY];
+};
+
+struct alignas(64) Worker
+{
+    JobDeque deque;
+    // Ring of job storage in jobStorage, a slot is reused MAX_JOBS_PER_WORKER
+    // jobs later if the job in it has finished
+    Job* jobs = nullptr;
+    uint32_t nextJob = 0;
+    // Jobs this worker took whose dependency wasn't done yet. Private to the
+    // worker, they can't go back into the deque: popping from the bottom
+    // would hand the same job back right away.
+    std::vector<Job*> blocked;
+    uint32_t stealSeed = 0;
+    std::thread thread;
+};
+
+std::unique_ptr<Worker[]> workers;
+// Job rings of all workers back to back, so any worker can find the flag of
+// a job it finished. A flag is set while its job is queued, blocked or
+// running, thieves and blocked lists can hold on to a job long after its
+// owner moved on.
+std::unique_ptr<Job[]> jobStorage;
+std::unique_ptr<std::atomic<bool>[]> jobLive;
+void (*onWorkerStart)(uint32_t) = nullptr;
+
+// Jobs queued and not finished yet, Shutdown waits for them
+std::atomic<uint32_t> activeJobs{0};
+// Jobs sitting in a deque, sleeping workers wake up when this is non zero
+std::atomic<uint32_t> queuedJobs{0};
+
+std::mutex wakeMutex;
+std::condition_variable wakeCondition;
+std::atomic<uint32_t> sleepingWorkers{0};
+std::atomic<bool> running{false};
+
+thread_local uint32_t workerIndex = UINT32_MAX;
+
+// Deque, job ring, live flags and blocked list of one worker
+constexpr uint64_t WORKER_STORAGE_SIZE = sizeof(Worker) +
+    (sizeof(Job) + sizeof(std::atomic<bool>) + sizeof(Job*)) * JobSystem::MAX_JOBS_PER_WORKER;
+
+Job* StealJob(uint32_t thief, uint32_t count)
+{
+    // Xorshift to start at a different victim every time, so the thieves
+    // don't all pile onto the same deque
+    uint32_t& seed = workers[thief].stealSeed;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    const uint32_t start = seed % count;
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t victim = (start + i) % count;
+        if (victim == thief)
+            continue;
+        if (Job* job = workers[victim].deque.Steal())
+            return job;
+    }
+    return nullptr;
+}
+
+Job* FindJob(uint32_t index, uint32_t count)
+{
+    auto& blocked = workers[index].blocked;
+    for (size_t i = 0; i < blocked.size(); i++) {
+        if (blocked[i]->dependency->IsDone()) {
+            Job* job = blocked[i];
+            blocked[i] = blocked.back();
+            blocked.pop_back();
+            return job;
+        }
+    }
+
+    Job* job = workers[index].deque.Pop();
+    if (!job)
+        job = StealJob(index, count);
+    if (job)
+        queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+}
+
+} // namespace
+
+void JobSystem::Init(const Config& config)
+{
+    EM_CORE_ASSERT(workerCount == 0, "Job system already initialized");
+
+    uint32_t count = config.workerCount;
+    if (count == 0)
+        count = std::thread::hardware_concurrency();
+    count = count == 0 ? 1 : (count > MAX_WORKERS ? MAX_WORKERS : count);
+
+    workers.reset(new Worker[count]);
+    jobStorage.reset(new Job[count * MAX_JOBS_PER_WORKER]);
+    jobLive.reset(new std::atomic<bool>[count * MAX_JOBS_PER_WORKER]());
+    for (uint32_t i = 0; i < count; i++) {
+        workers[i].jobs = &jobStorage[i * MAX_JOBS_PER_WORKER];
+        workers[i].blocked.reserve(MAX_JOBS_PER_WORKER);
+        workers[i].stealSeed = 0x9E3779B9u * (i + 1);
+    }
+
+    MemoryTracker::RecordAllocation(MemoryDomain::Cpu, MemoryTag::Jobs, WORKER_STORAGE_SIZE * count);
+
+    onWorkerStart = config.onWorkerStart;
+    running.store(true, std::memory_order_relaxed);
+    workerCount = count;
+
+    workerIndex = 0;
+    if (onWorkerStart)
+        onWorkerStart(0);
+
+    for (uint32_t i = 1; i < count; i++) {
+        workers[i].thread = std::thread([i, count]() {
+            workerIndex = i;
+            if (onWorkerStart)
+                onWorkerStart(i);
+
+            while (running.load(std::memory_order_acquire)) {
+                if (Job* job = FindJob(i, count)) {
+                    Execute(job, i);
+                    continue;
+                }
+
+                // Only blocked jobs left, they are checked again next round
+                if (!workers[i].blocked.empty()) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                // Nothing to do, sleep until a job is queued. The sleeper
+                // count and the queued count are both seq_cst so either the
+                // submitter sees a sleeper or the sleeper sees the job.
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                sleepingWorkers.fetch_add(1);
+                wakeCondition.wait(lock, []() {
+                    return queuedJobs.load() > 0 || !running.load(std::memory_order_acquire);
+                });
+                sleepingWorkers.fetch_sub(1);
+            }
+        });
+    }
+}
+
+void JobSystem::Shutdown()
+{
+    if (workerCount == 0)
+        return;
+
+    EM_CORE_ASSERT(workerIndex == 0, "Job system must be shut down by the thread that initialized it");
+
+    // Help finish whatever is still queued
+    while (activeJobs.load(std::memory_order_acquire) > 0) {
+        if (Job* job = FindJob(0, workerCount))
+            Execute(job, 0);
+        else
+            std::this_thread::yield();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        running.store(false, std::memory_order_release);
+    }
+    wakeCondition.notify_all();
+
+    for (uint32_t i = 1; i < workerCount; i++)
+        workers[i].thread.join();
+
+    MemoryTracker::RecordFree(MemoryDomain::Cpu, MemoryTag::Jobs, WORKER_STORAGE_SIZE * workerCount);
+    workerCount = 0;
+    workerIndex = UINT32_MAX;
+    workers.reset();
+    jobStorage.reset();
+    jobLive.reset();
+}
+
+bool JobSystem::Execute(Job* job, uint32_t index)
+{
+    if (job->dependency && !job->dependency->IsDone()) {
+        workers[index].blocked.push_back(job);
+        return false;
+    }
+
+    job->invoke(*job);
+
+    JobCounter* counter = job->counter;
+    // Last touch of the slot, its owner may reuse it from here on
+    jobLive[job - jobStorage.get()].store(false, std::memory_order_release);
+
+    if (counter)
+        counter->value_.fetch_sub(1, std::memory_order_release);
+    activeJobs.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+uint32_t JobSystem::GetWorkerIndex()
+{
+    return workerIndex;
+}
+
+bool JobSystem::PinCurrentThread(uint32_t cpu)
+{
+#ifdef EM_PLATFORM_WINDOWS
+    if (cpu >= 64)
+        return false;
+    return SetThreadAffinityMask(GetCurrentThread(), 1ull << cpu) != 0;
+#else
+    if (cpu >= CPU_SETSIZE)
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+void JobSystem::Submit(const Job& job)
+{
+    const uint32_t index = workerIndex;
+    if (workerCount == 0 || index == UINT32_MAX) {
+        // No deque to push to, run it here
+        if (job.dependency)
+            Wait(*job.dependency);
+        Job copy = job;
+        copy.invoke(copy);
+        return;
+    }
+
+    Worker& worker = workers[index];
+    const uint32_t slotIndex = worker.nextJob & (MAX_JOBS_PER_WORKER - 1);
+    std::atomic<bool>& live = jobLive[index * MAX_JOBS_PER_WORKER + slotIndex];
+    if (EM_UNLIKELY(live.load(std::memory_order_acquire))) {
+        // The job MAX_JOBS_PER_WORKER submissions back is still in flight
+        // somewhere, its storage can't be reused. Run this one here instead.
+        if (job.dependency)
+            Wait(*job.dependency);
+        Job copy = job;
+        copy.invoke(copy);
+        return;
+    }
+
+    worker.nextJob++;
+    Job* slot = &worker.jobs[slotIndex];
+    *slot = job;
+    live.store(true, std::memory_order_relaxed);
+
+    if (job.counter)
+        job.counter->value_.fetch_add(1, std::memory_order_relaxed);
+    activeJobs.fetch_add(1, std::memory_order_relaxed);
+
+    queuedJobs.fetch_add(1);
+    if (!worker.deque.Push(slot)) {
+        // Deque full, the job runs right away instead
+        queuedJobs.fetch_sub(1);
+        Execute(slot, index);
+        return;
+    }
+
+    if (sleepingWorkers.load() > 0) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeCondition.notify_one();
+    }
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+    const uint32_t index = workerIndex;
+    while (!counter.IsDone()) {
+        Job* job = (workerCount > 0 && index != UINT32_MAX) ? FindJob(index, workerCount) : nullptr;
+        if (!job || !Execute(job, index))
+            std::this_thread::yield();
+    }
+}
+
+bool JobSystem::TryRunJob()
+{
+    const uint32_t index = workerIndex;
+    if (workerCount == 0 || index == UINT32_MAX)
+        return false;
+
+    Job* job = FindJob(index, workerCount);
+    return job && Execute(job, index);
+}
+
+} // namespace ember
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ember
+{
+
+// Number of jobs that haven't finished yet. A job run with a counter bumps it
+// when queued and drops it once done, Wait on it or make other jobs depend on
+// it. Must outlive the jobs counting on it.
+class JobCounter
+{
+public:
+    JobCounter() = default;
+
+    // Delete copy contructors
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    inline bool IsDone() const { return value_.load(std::memory_order_acquire) == 0; }
+    inline uint32_t GetValue() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    friend class JobSystem;
+    friend class FiberScheduler;
+
+    std::atomic<uint32_t> value_{0};
+};
+
+// A function and its captures, stored inline so queuing a job never touches
+// the heap. One cache line each.
+struct alignas(64) Job
+{
+    static constexpr uint32_t PAYLOAD_SIZE = 40;
+
+    void (*invoke)(Job& job);
+    JobCounter* counter;
+    // Not started before this reaches zero, may be null
+    const JobCounter* dependency;
+    alignas(8) unsigned char payload[PAYLOAD_SIZE];
+};
+
+// Work stealing job system. Every worker owns a Chase-Lev deque: it pushes and
+// pops its own jobs at the bottom without taking a lock, idle workers steal
+// from the top of the others'. The thread calling Init is worker 0 and only
+// runs jobs while it waits on a counter, the others are background threads
+// that sleep when there is nothing to steal.
+//
+// Jobs may only be queued from worker threads, anywhere else Run executes the
+// job right away. Without Init every job runs inline on the calling thread.
+class JobSystem
+{
+public:
+    // Jobs a worker can have queued, and jobs it can have in flight before
+    // their storage is reused. Past that, new jobs run right away on the
+    // submitting thread.
+    static constexpr uint32_t MAX_JOBS_PER_WORKER = 4096;
+    static_assert((MAX_JOBS_PER_WORKER & (MAX_JOBS_PER_WORKER - 1)) == 0, "Job count must be a power of 2");
+    static constexpr uint32_t MAX_WORKERS = 64;
+
+    struct Config
+    {
+        // Including the thread calling Init, 0 uses one per hardware thread
+        uint32_t workerCount = 0;
+        // Called first thing on every worker thread, e.g. to pin it with
+        // PinCurrentThread. Worker 0 is the thread calling Init.
+        void (*onWorkerStart)(uint32_t workerIndex) = nullptr;
+    };
+
+    static void Init(const Config& config);
+    // Waits for the queued jobs to finish, then joins the workers
+    static void Shutdown();
+
+    static bool IsInitialized() { return workerCount > 0; }
+    static uint32_t GetWorkerCount() { return workerCount > 0 ? workerCount : 1; }
+    // Index of the calling worker, UINT32_MAX on other threads
+    static uint32_t GetWorkerIndex();
+
+    // Restricts the calling thread to one logical processor. Returns false
+    // if the platform refused.
+    static bool PinCurrentThread(uint32_t cpu);
+
+    // function must be trivially copyable and fit in Job::PAYLOAD_SIZE,
+    // capture by reference or through a pointer if it doesn't
+    template<typename F>
+    static void Run(F&& function, JobCounter* counter = nullptr, const JobCounter* dependency = nullptr)
+    {
+        Submit(MakeJob(std::forward<F>(function), counter, dependency));
+    }
+
+    template<typename F>
+    static Job MakeJob(F&& function, JobCounter* counter = nullptr, const JobCounter* dependency = nullptr)
+    {
+        using Function = std::decay_t<F>;
+        static_assert(sizeof(Function) <= Job::PAYLOAD_SIZE, "Job captures too much, capture a pointer instead");
+        static_assert(alignof(Function) <= 8, "Job captures are over-aligned");
+        static_assert(std::is_trivially_copyable<Function>::value, "Job captures must be trivially copyable");
+
+        Job job;
+        job.invoke = [](Job& self) { (*std::launder(reinterpret_cast<Function*>(self.payload)))(); };
+        job.counter = counter;
+        job.dependency = dependency;
+        new (job.payload) Function(std::forward<F>(function));
+        return job;
+    }
+
+    // Runs jobs until counter reaches zero instead of blocking the thread
+    static void Wait(const JobCounter& counter);
+    // Runs one job if the calling worker finds any. Returns false if it
+    // didn't, or if the thread isn't a worker.
+    static bool TryRunJob();
+
+    // Calls function(begin, end) over [0, count) in batches of batchSize
+    // spread across the workers and returns once every batch is done.
+    // Batches run in any order and concurrently, they must not touch the same
+    // elements.
+    template<typename F>
+    static void ParallelFor(uint32_t count, uint32_t batchSize, const F& function)
+    {
+        batchSize = batchSize > 0 ? batchSize : 1;
+        if (count <= batchSize || GetWorkerCount() == 1 || GetWorkerIndex() == UINT32_MAX) {
+            function(0u, count);
+            return;
+        }
+
+        JobCounter counter;
+        const F* shared = &function;
+        for (uint32_t begin = 0; begin < count; begin += batchSize) {
+            const uint32_t end = count - begin > batchSize ? begin + batchSize : count;
+            Run([shared, begin, end]() { (*shared)(begin, end); }, &counter);
+        }
+        Wait(counter);
+    }
+
+private:
+    static void Submit(const Job& job);
+    // Runs the job and counts it as done. Returns false if its dependency
+    // isn't done yet, the worker sets it aside and checks it again later.
+    static bool Execute(Job* job, uint32_t workerIndex);
+
+    static uint32_t workerCount;
+};
+
+} // namespace ember
@@ -1,29 +1,105 @@
 #include "Logger.hpp"
 
+#include "AsyncLogSink.hpp"
+
 namespace ember
 {
 
 std::shared_ptr<spdlog::logger> Logger::logger;
 std::shared_ptr<spdlog::logger> Logger::coreLogger;
+std::shared_ptr<AsyncLogSink> Logger::asyncSink;
 bool Logger::initialized = false;
 
-void Logger::Init()
+static const char* LOG_PATTERN = "%^[%n]: [%s, %#]: [%l]: %v%$";
+
+// Writes straight to the console, not registered with spdlog so the next
+// Init can take the name again
+static std::shared_ptr<spdlog::logger> createShutdownLogger(const std::shared_ptr<spdlog::logger>& logger)
+{
+    auto console = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    auto shutdownLogger = std::make_shared<spdlog::logger>(logger->name(), console);
+    shutdownLogger->set_pattern(LOG_PATTERN);
+    shutdownLogger->set_level(logger->level());
+    return shutdownLogger;
+}
+
+void Logger::Init(const LoggerConfig& config)
 {
     if (Logger::initialized) {
         EM_LOG_WARN("Logger already initialized");
         return;
     }
 
-    spdlog::set_pattern("%^[%n]: [%s, %#]: [%l]: %v%$");
+    spdlog::set_pattern(LOG_PATTERN);
+
+    std::shared_ptr<spdlog::logger> appLogger;
+    std::shared_ptr<spdlog::logger> engineLogger;
+    if (config.mode == LogMode::Async) {
+        // Both loggers share one queue and one background thread
+        auto console = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+        Logger::asyncSink = std::make_shared<AsyncLogSink>(console, config.asyncQueueSize, config.overflowPolicy);
 
-    Logger::logger = spdlog::stdout_color_mt("App");
-    Logger::logger->set_level(spdlog::level::trace);
+        appLogger = std::make_shared<spdlog::logger>("App", Logger::asyncSink);
+        engineLogger = std::make_shared<spdlog::logger>("EmberLily", Logger::asyncSink);
+        spdlog::initialize_logger(appLogger);
+        spdlog::initialize_logger(engineLogger);
 
-    Logger::coreLogger = spdlog::stdout_color_mt("EmberLily");
-    Logger::coreLogger->set_level(spdlog::level::trace);
+        // Errors usually come right before an assert, make sure they're out
+        appLogger->flush_on(spdlog::level::err);
+        engineLogger->flush_on(spdlog::level::err);
+    } else {
+        appLogger = spdlog::stdout_color_mt("App");
+        engineLogger = spdlog::stdout_color_mt("EmberLily");
+    }
+
+    appLogger->set_level(config.appLevel);
+    engineLogger->set_level(config.coreLevel);
+    std::atomic_store(&Logger::logger, appLogger);
+    std::atomic_store(&Logger::coreLogger, engineLogger);
 
     Logger::initialized = true;
     EM_LOG_INFO("Initialized Log");
 }
 
-} // namespace ember
\ No newline at end of file
+void Logger::Shutdown()
+{
+    if (!Logger::initialized)
+        return;
+
+    if (Logger::asyncSink)
+        Logger::asyncSink->stop();
+
+    // Objects destroyed after this may still log, they get loggers of their
+    // own until the next Init sets up the configured ones again. Other
+    // threads may be logging, the swap goes through atomic_store and the
+    // macros hold a reference while they use the old logger.
+    const auto appLogger = GetLogger();
+    const auto engineLogger = GetCoreLogger();
+    spdlog::drop(appLogger->name());
+    spdlog::drop(engineLogger->name());
+    std::atomic_store(&Logger::logger, createShutdownLogger(appLogger));
+    std::atomic_store(&Logger::coreLogger, createShutdownLogger(engineLogger));
+    Logger::asyncSink.reset();
+
+    Logger::initialized = false;
+}
+
+void Logger::SetLevel(spdlog::level::level_enum level)
+{
+    GetLogger()->set_level(level);
+}
+
+void Logger::SetCoreLevel(spdlog::level::level_enum level)
+{
+    GetCoreLogger()->set_level(level);
+}
+
+AsyncLogStats Logger::GetAsyncStats()
+{
+    if (!Logger::asyncSink)
+        return AsyncLogStats{};
+
+    return Logger::asyncSink->getStats();
+}
+
+} // namespace ember
@@ -1,10 +1,29 @@
 #pragma once
 
-#define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
-#define SPDLOG_DEBUG_ON
-#define SPDLOG_TRACE_ON
+// Log calls below EM_LOG_LEVEL are removed by the preprocessor, arguments
+// included. Set it from the build (see EM_LOG_LEVEL in CMakeLists.txt),
+// otherwise debug builds keep everything and release builds start at info.
+#define EM_LOG_LEVEL_TRACE 0
+#define EM_LOG_LEVEL_DEBUG 1
+#define EM_LOG_LEVEL_INFO 2
+#define EM_LOG_LEVEL_WARN 3
+#define EM_LOG_LEVEL_ERROR 4
+#define EM_LOG_LEVEL_OFF 6
 
+#ifndef EM_LOG_LEVEL
+    #ifdef NDEBUG
+        #define EM_LOG_LEVEL EM_LOG_LEVEL_INFO
+    #else
+        #define EM_LOG_LEVEL EM_LOG_LEVEL_TRACE
+    #endif
+#endif
+
+// Keep spdlog's own macros in line with ours
+#define SPDLOG_ACTIVE_LEVEL EM_LOG_LEVEL
+
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/fmt/ostr.h>
@@ -15,56 +34,134 @@
 // including the library No need to have them defined to clutter the rest of the
 // program
 #undef SPDLOG_ACTIVE_LEVEL
-#undef SPDLOG_DEBUG_ON
-#undef SPDLOG_TRACE_ON
 
 namespace ember
 {
 
+class AsyncLogSink;
+
+enum class LogMode
+{
+    // Every call formats and writes to the console before returning
+    Sync,
+    // Calls copy the message into a lock-free queue, a background thread
+    // formats and writes it
+    Async
+};
+
+// What an async log call does when the queue is full
+enum class LogOverflowPolicy
+{
+    Block,              // wait for the background thread to make room
+    Drop,               // discard the new message
+    OverwriteOldest     // discard the oldest queued message
+};
+
+struct LoggerConfig
+{
+    LogMode mode = LogMode::Sync;
+    LogOverflowPolicy overflowPolicy = LogOverflowPolicy::Block;
+    // Rounded up to a power of 2
+    uint32_t asyncQueueSize = 8192;
+    // Runtime levels, on top of what EM_LOG_LEVEL already compiled out
+    spdlog::level::level_enum appLevel = spdlog::level::trace;
+    spdlog::level::level_enum coreLevel = spdlog::level::trace;
+};
+
+struct AsyncLogStats
+{
+    uint64_t enqueued = 0;
+    uint64_t dropped = 0;       // lost to LogOverflowPolicy::Drop
+    uint64_t overwritten = 0;   // lost to LogOverflowPolicy::OverwriteOldest
+    uint64_t blocked = 0;       // calls that had to wait with LogOverflowPolicy::Block
+    uint64_t truncated = 0;     // messages cut to the queue's inline payload size
+};
+
 class Logger
 {
 public:
-    static void Init();
+    static void Init(const LoggerConfig& config = LoggerConfig{});
+    // Writes out everything still queued and stops the async thread. Logging
+    // keeps working afterwards, synchronously, and Init can be called again
+    // with a different config.
+    static void Shutdown();
+    // Zeros in sync mode
+    static AsyncLogStats GetAsyncStats();
+
+    // Change the runtime level of the client (App) and engine (EmberLily)
+    // loggers. Calls below it skip formatting and argument evaluation.
+    static void SetLevel(spdlog::level::level_enum level);
+    static void SetCoreLevel(spdlog::level::level_enum level);
 
-    inline static std::shared_ptr<spdlog::logger>& GetLogger()
+    // Shutdown and Init swap the loggers while other threads may log, they
+    // are loaded and stored atomically
+    inline static std::shared_ptr<spdlog::logger> GetLogger()
     {
-        return Logger::logger;
+        return std::atomic_load(&Logger::logger);
     }
 
-    inline static std::shared_ptr<spdlog::logger>& GetCoreLogger()
+    inline static std::shared_ptr<spdlog::logger> GetCoreLogger()
     {
-        return Logger::coreLogger;
+        return std::atomic_load(&Logger::coreLogger);
     }
 
 
 private:
     static std::shared_ptr<spdlog::logger> logger;
     static std::shared_ptr<spdlog::logger> coreLogger;
+    static std::shared_ptr<AsyncLogSink> asyncSink;
     static bool initialized;
 };
 
 } // namespace ember
 
+// Checks the runtime level before evaluating the arguments
+#define EM_LOG_CALL(loggerPtr, logLevel, ...)                                  \
+    do {                                                                       \
+        const std::shared_ptr<spdlog::logger> emLogger_ = (loggerPtr);         \
+        if (emLogger_->should_log(logLevel))                                   \
+            SPDLOG_LOGGER_CALL(emLogger_, logLevel, __VA_ARGS__);              \
+    } while (0)
+
+#define EM_LOG_DISABLED(...) ((void)0)
+
 // Client log macros
-#define LOG_TRACE(...)                                                         \
-    SPDLOG_LOGGER_TRACE(::ember::Logger::GetLogger(), __VA_ARGS__)
-#define LOG_DEBUG(...)                                                         \
-    SPDLOG_LOGGER_DEBUG(::ember::Logger::GetLogger(), __VA_ARGS__)
-#define LOG_INFO(...)                                                          \
-    SPDLOG_LOGGER_INFO(::ember::Logger::GetLogger(), __VA_ARGS__)
-#define LOG_WARN(...)                                                          \
-    SPDLOG_LOGGER_WARN(::ember::Logger::GetLogger(), __VA_ARGS__)
-#define LOG_ERROR(...)                                                         \
-    SPDLOG_LOGGER_ERROR(::ember::Logger::GetLogger(), __VA_ARGS__)
-
-// EmberLily log macros
-#define EM_LOG_TRACE(...)                                                         \
-    SPDLOG_LOGGER_TRACE(::ember::Logger::GetCoreLogger(), __VA_ARGS__)
-#define EM_LOG_DEBUG(...)                                                         \
-    SPDLOG_LOGGER_DEBUG(::ember::Logger::GetCoreLogger(), __VA_ARGS__)
-#define EM_LOG_INFO(...)                                                          \
-    SPDLOG_LOGGER_INFO(::ember::Logger::GetCoreLogger(), __VA_ARGS__)
-#define EM_LOG_WARN(...)                                                          \
-    SPDLOG_LOGGER_WARN(::ember::Logger::GetCoreLogger(), __VA_ARGS__)
-#define EM_LOG_ERROR(...)                                                         \
-    SPDLOG_LOGGER_ERROR(::ember::Logger::GetCoreLogger(), __VA_ARGS__)
\ No newline at end of file
+#if EM_LOG_LEVEL <= EM_LOG_LEVEL_TRACE
+    #define LOG_TRACE(...) EM_LOG_CALL(::ember::Logger::GetLogger(), spdlog::level::trace, __VA_ARGS__)
+    #define EM_LOG_TRACE(...) EM_LOG_CALL(::ember::Logger::GetCoreLogger(), spdlog::level::trace, __VA_ARGS__)
+#else
+    #define LOG_TRACE(...) EM_LOG_DISABLED(__VA_ARGS__)
+    #define EM_LOG_TRACE(...) EM_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if EM_LOG_LEVEL <= EM_LOG_LEVEL_DEBUG
+    #define LOG_DEBUG(...) EM_LOG_CALL(::ember::Logger::GetLogger(), spdlog::level::debug, __VA_ARGS__)
+    #define EM_LOG_DEBUG(...) EM_LOG_CALL(::ember::Logger::GetCoreLogger(), spdlog::level::debug, __VA_ARGS__)
+#else
+    #define LOG_DEBUG(...) EM_LOG_DISABLED(__VA_ARGS__)
+    #define EM_LOG_DEBUG(...) EM_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if EM_LOG_LEVEL <= EM_LOG_LEVEL_INFO
+    #define LOG_INFO(...) EM_LOG_CALL(::ember::Logger::GetLogger(), spdlog::level::info, __VA_ARGS__)
+    #define EM_LOG_INFO(...) EM_LOG_CALL(::ember::Logger::GetCoreLogger(), spdlog::level::info, __VA_ARGS__)
+#else
+    #define LOG_INFO(...) EM_LOG_DISABLED(__VA_ARGS__)
+    #define EM_LOG_INFO(...) EM_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if EM_LOG_LEVEL <= EM_LOG_LEVEL_WARN
+    #define LOG_WARN(...) EM_LOG_CALL(::ember::Logger::GetLogger(), spdlog::level::warn, __VA_ARGS__)
+    #define EM_LOG_WARN(...) EM_LOG_CALL(::ember::Logger::GetCoreLogger(), spdlog::level::warn, __VA_ARGS__)
+#else
+    #define LOG_WARN(...) EM_LOG_DISABLED(__VA_ARGS__)
+    #define EM_LOG_WARN(...) EM_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if EM_LOG_LEVEL <= EM_LOG_LEVEL_ERROR
+    #define LOG_ERROR(...) EM_LOG_CALL(::ember::Logger::GetLogger(), spdlog::level::err, __VA_ARGS__)
+    #define EM_LOG_ERROR(...) EM_LOG_CALL(::ember::Logger::GetCoreLogger(), spdlog::level::err, __VA_ARGS__)
+#else
+    #define LOG_ERROR(...) EM_LOG_DISABLED(__VA_ARGS__)
+    #define EM_LOG_ERROR(...) EM_LOG_DISABLED(__VA_ARGS__)
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Defines.hpp"
+
+namespace ember
+{
+
+// Read only view of a whole file mapped into memory. Pages are read in by
+// the OS as they are touched, nothing is copied into a buffer of our own.
+// The mapping is hinted as sequential so the OS reads ahead.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    // Delete copy contructors
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Closes any file mapped before. Returns false if the file can't be
+    // opened or mapped, an empty file can't be mapped either.
+    bool Open(const char* path);
+    void Close();
+
+    inline bool IsOpen() const { return data_ != nullptr; }
+    inline const void* GetData() const { return data_; }
+    inline size_t GetSize() const { return size_; }
+
+private:
+    const void* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef EM_PLATFORM_WINDOWS
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+} // namespace ember
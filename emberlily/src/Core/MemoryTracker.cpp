@@ -0,0 +1,106 @@
+#include "MemoryTracker.hpp"
+
+#include "Logger.hpp"
+
+namespace ember
+{
+
+MemoryTracker::Counters MemoryTracker::counters[static_cast<uint32_t>(MemoryDomain::Count)]
+                                              [static_cast<uint32_t>(MemoryTag::Count)];
+
+namespace
+{
+
+const char* tagNames[static_cast<uint32_t>(MemoryTag::Count)] = {
+    "untagged",
+    "models",
+    "swapchain",
+    "pipelines",
+    "events",
+    "logging",
+    "frame",
+    "scratch",
+    "jobs",
+    "streaming",
+};
+
+inline double ToMegabytes(uint64_t bytes)
+{
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+void MemoryTracker::RecordAllocation(MemoryDomain domain, MemoryTag tag, uint64_t bytes)
+{
+    Counters& c = counters[static_cast<uint32_t>(domain)][static_cast<uint32_t>(tag)];
+
+    const uint64_t live = c.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    c.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+    c.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t peak = c.peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !c.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void MemoryTracker::RecordFree(MemoryDomain domain, MemoryTag tag, uint64_t bytes)
+{
+    Counters& c = counters[static_cast<uint32_t>(domain)][static_cast<uint32_t>(tag)];
+
+    c.liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    c.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+}
+
+MemoryTracker::TagStats MemoryTracker::GetStats(MemoryDomain domain, MemoryTag tag)
+{
+    const Counters& c = counters[static_cast<uint32_t>(domain)][static_cast<uint32_t>(tag)];
+
+    TagStats stats;
+    stats.liveBytes = c.liveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = c.peakBytes.load(std::memory_order_relaxed);
+    stats.liveAllocations = c.liveAllocations.load(std::memory_order_relaxed);
+    stats.totalAllocations = c.totalAllocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t MemoryTracker::GetLiveBytes(MemoryDomain domain)
+{
+    uint64_t total = 0;
+    for (uint32_t tag = 0; tag < static_cast<uint32_t>(MemoryTag::Count); tag++)
+        total += counters[static_cast<uint32_t>(domain)][tag].liveBytes.load(std::memory_order_relaxed);
+    return total;
+}
+
+const char* MemoryTracker::GetTagName(MemoryTag tag)
+{
+    return tag < MemoryTag::Count ? tagNames[static_cast<uint32_t>(tag)] : "unknown";
+}
+
+void MemoryTracker::LogReport()
+{
+    EM_LOG_INFO(
+        "Tracked memory: {0:.2f} MB host, {1:.2f} MB device",
+        ToMegabytes(GetLiveBytes(MemoryDomain::Cpu)),
+        ToMegabytes(GetLiveBytes(MemoryDomain::Gpu)));
+
+    const char* domainNames[] = {"host", "device"};
+    for (uint32_t domain = 0; domain < static_cast<uint32_t>(MemoryDomain::Count); domain++) {
+        for (uint32_t tag = 0; tag < static_cast<uint32_t>(MemoryTag::Count); tag++) {
+            const TagStats stats = GetStats(static_cast<MemoryDomain>(domain), static_cast<MemoryTag>(tag));
+            if (stats.totalAllocations == 0)
+                continue;
+
+            EM_LOG_INFO(
+                "  {0:<6} {1:<10} live {2:9.2f} MB in {3:6}  peak {4:9.2f} MB  allocations {5}",
+                domainNames[domain],
+                tagNames[tag],
+                ToMegabytes(stats.liveBytes),
+                stats.liveAllocations,
+                ToMegabytes(stats.peakBytes),
+                stats.totalAllocations);
+        }
+    }
+}
+
+} // namespace ember
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace ember
+{
+
+// Subsystem an allocation is charged to
+enum class MemoryTag : uint32_t
+{
+    Untagged,
+    Models,
+    SwapChain,
+    Pipelines,
+    Events,
+    Logging,
+    Frame,
+    Scratch,
+    Jobs,
+    Streaming,
+    Count
+};
+
+enum class MemoryDomain : uint32_t
+{
+    Cpu,
+    Gpu,
+    Count
+};
+
+// Live and peak bytes per tag, for host memory and device memory separately.
+// Only what is reported to it is counted: the engine's allocators and
+// subsystems record their big blocks, LlyDevice records every device memory
+// allocation and driver host allocations made through its callbacks. Plain
+// new/delete isn't tracked. Counting is a few relaxed atomics, any thread
+// may record.
+class MemoryTracker
+{
+public:
+    struct TagStats
+    {
+        uint64_t liveBytes;
+        uint64_t peakBytes;
+        uint64_t liveAllocations;
+        uint64_t totalAllocations;
+    };
+
+    static void RecordAllocation(MemoryDomain domain, MemoryTag tag, uint64_t bytes);
+    static void RecordFree(MemoryDomain domain, MemoryTag tag, uint64_t bytes);
+
+    static TagStats GetStats(MemoryDomain domain, MemoryTag tag);
+    static uint64_t GetLiveBytes(MemoryDomain domain);
+
+    static const char* GetTagName(MemoryTag tag);
+
+    // Logs every tag that ever had an allocation
+    static void LogReport();
+
+private:
+    struct Counters
+    {
+        std::atomic<uint64_t> liveBytes{0};
+        std::atomic<uint64_t> peakBytes{0};
+        std::atomic<uint64_t> liveAllocations{0};
+        std::atomic<uint64_t> totalAllocations{0};
+    };
+
+    static Counters counters[static_cast<uint32_t>(MemoryDomain::Count)][static_cast<uint32_t>(MemoryTag::Count)];
+};
+
+} // namespace ember
@@ -0,0 +1,214 @@
+#include "Profiler.hpp"
+
+#include <cstdio>
+#include <mutex>
+
+#include "Asserts.hpp"
+
+namespace ember
+{
+
+std::atomic<Profiler::ThreadBuffer*> Profiler::threadBuffers{nullptr};
+Profiler::ThreadBuffer* Profiler::freeBuffers = nullptr;
+Profiler::FrameSummary Profiler::lastFrame;
+std::vector<Profiler::ScopeEvent> Profiler::gpuEvents;
+std::vector<Profiler::ScopeEvent> Profiler::capture;
+bool Profiler::capturing = false;
+
+static std::atomic<uint32_t> threadCount{0};
+static std::mutex freeBuffersMutex;
+
+Profiler::ThreadBuffer* Profiler::AcquireThreadBuffer()
+{
+    // Buffers are never freed, EndFrame may still be reading one after its
+    // thread has exited. New threads take over the buffers of exited ones,
+    // so there are only ever as many as threads alive at once. The ring
+    // carries on where the last thread left it.
+    {
+        std::lock_guard<std::mutex> lock(freeBuffersMutex);
+        if (ThreadBuffer* buffer = freeBuffers) {
+            freeBuffers = buffer->nextFree;
+            buffer->depth = 0;
+            return buffer;
+        }
+    }
+
+    auto* buffer = new ThreadBuffer();
+    buffer->threadIndex = threadCount.fetch_add(1, std::memory_order_relaxed);
+
+    ThreadBuffer* head = threadBuffers.load(std::memory_order_relaxed);
+    do {
+        buffer->next = head;
+    } while (!threadBuffers.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+
+    return buffer;
+}
+
+void Profiler::ReleaseThreadBuffer(ThreadBuffer* buffer)
+{
+    std::lock_guard<std::mutex> lock(freeBuffersMutex);
+    buffer->nextFree = freeBuffers;
+    freeBuffers = buffer;
+}
+
+void Profiler::BeginScope(const char* name)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+
+    // Scopes nested deeper than the buffer tracks are counted and skipped,
+    // depth keeps counting so their ends are skipped too
+    if (EM_UNLIKELY(buffer.depth >= ThreadBuffer::MAX_DEPTH)) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        buffer.depth++;
+        return;
+    }
+
+    buffer.openNames[buffer.depth] = name;
+    buffer.openTicks[buffer.depth] = Clock::Ticks();
+    buffer.depth++;
+}
+
+void Profiler::EndScope()
+{
+    const uint64_t endTicks = Clock::Ticks();
+    ThreadBuffer& buffer = GetThreadBuffer();
+
+    // An end without a begin on this thread, a fiber job may have resumed
+    // on another worker inside its scope
+    if (EM_UNLIKELY(buffer.depth == 0))
+        return;
+    buffer.depth--;
+    if (EM_UNLIKELY(buffer.depth >= ThreadBuffer::MAX_DEPTH))
+        return;
+
+    const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    ScopeEvent& event = buffer.events[head & (EVENTS_PER_THREAD - 1)];
+    event.name = buffer.openNames[buffer.depth];
+    event.startTicks = buffer.openTicks[buffer.depth];
+    event.endTicks = endTicks;
+    event.depth = buffer.depth;
+    event.threadIndex = buffer.threadIndex;
+
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::AddGpuScope(const char* name, uint64_t startTicks, uint64_t endTicks, uint32_t depth)
+{
+    gpuEvents.push_back(ScopeEvent{name, startTicks, endTicks, depth, GPU_THREAD_INDEX});
+}
+
+void Profiler::Summarize(std::vector<ScopeSummary>& scopes, const ScopeEvent& event, double ticksPerMillisecond)
+{
+    const double milliseconds = static_cast<double>(event.endTicks - event.startTicks) / ticksPerMillisecond;
+
+    // Few distinct names per frame, a linear search beats hashing.
+    // Names are compared by pointer, each call site has its own.
+    ScopeSummary* summary = nullptr;
+    for (auto& scope : scopes) {
+        if (scope.name == event.name) {
+            summary = &scope;
+            break;
+        }
+    }
+    if (!summary) {
+        scopes.push_back(ScopeSummary{event.name, 0, event.depth, 0.0});
+        summary = &scopes.back();
+    }
+    summary->calls++;
+    summary->milliseconds += milliseconds;
+}
+
+void Profiler::EndFrame()
+{
+    lastFrame.frame++;
+    lastFrame.scopes.clear();
+    lastFrame.gpuScopes.clear();
+    lastFrame.lostEvents = 0;
+    lastFrame.droppedScopes = 0;
+
+    const double ticksPerMillisecond = Clock::TicksPerSecond() / 1000.0;
+
+    for (ThreadBuffer* buffer = threadBuffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+
+        const uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+        lastFrame.droppedScopes += dropped - buffer->droppedCollected;
+        buffer->droppedCollected = dropped;
+
+        // The thread lapped the ring since the last collection
+        if (head - buffer->collected > EVENTS_PER_THREAD) {
+            lastFrame.lostEvents += head - buffer->collected - EVENTS_PER_THREAD;
+            buffer->collected = head - EVENTS_PER_THREAD;
+        }
+
+        for (uint64_t i = buffer->collected; i < head; i++) {
+            const ScopeEvent& event = buffer->events[i & (EVENTS_PER_THREAD - 1)];
+            Summarize(lastFrame.scopes, event, ticksPerMillisecond);
+
+            if (capturing)
+                capture.push_back(event);
+        }
+
+        buffer->collected = head;
+    }
+
+    for (const auto& event : gpuEvents) {
+        Summarize(lastFrame.gpuScopes, event, ticksPerMillisecond);
+        if (capturing)
+            capture.push_back(event);
+    }
+    gpuEvents.clear();
+}
+
+void Profiler::BeginCapture()
+{
+    capture.clear();
+    capturing = true;
+}
+
+bool Profiler::EndCapture(const std::string& path)
+{
+    capturing = false;
+
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        EM_LOG_ERROR("Could not write profiler capture to {0}", path);
+        return false;
+    }
+
+    uint64_t firstTicks = UINT64_MAX;
+    for (const auto& event : capture)
+        firstTicks = event.startTicks < firstTicks ? event.startTicks : firstTicks;
+
+    const double ticksPerMicrosecond = Clock::TicksPerSecond() / 1e6;
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(
+        file,
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}%s\n",
+        GPU_THREAD_INDEX,
+        capture.empty() ? "" : ",");
+    for (size_t i = 0; i < capture.size(); i++) {
+        const ScopeEvent& event = capture[i];
+        const bool gpu = event.threadIndex == GPU_THREAD_INDEX;
+        std::fprintf(
+            file,
+            "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+            event.name,
+            gpu ? "gpu" : "cpu",
+            event.threadIndex,
+            static_cast<double>(event.startTicks - firstTicks) / ticksPerMicrosecond,
+            static_cast<double>(event.endTicks - event.startTicks) / ticksPerMicrosecond,
+            i + 1 < capture.size() ? "," : "");
+    }
+    std::fprintf(file, "]}\n");
+
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+
+    EM_LOG_INFO("Wrote {0} profiler scopes to {1}", capture.size(), path);
+    capture.clear();
+    return ok;
+}
+
+} // namespace ember
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Clock.hpp"
+
+namespace ember
+{
+
+// Scoped CPU timer. EM_PROFILE_SCOPE("name") / EM_PROFILE_FUNCTION() record
+// the start and end ticks of the enclosing scope into a per-thread ring
+// buffer owned by that thread alone, so recording takes no lock.
+//
+// Profiler::EndFrame, called once per frame by the main thread, collects what
+// every thread recorded since the last call. It sums it up per scope name and,
+// while a capture is running, keeps every scope for a Chrome trace
+// (chrome://tracing or https://ui.perfetto.dev).
+class Profiler
+{
+public:
+    // Scopes a thread can record between two EndFrame calls
+    static constexpr uint32_t EVENTS_PER_THREAD = 16384;
+    static_assert((EVENTS_PER_THREAD & (EVENTS_PER_THREAD - 1)) == 0, "Event count must be a power of 2");
+    // Thread index of the scopes timed on the GPU, shown as their own track
+    static constexpr uint32_t GPU_THREAD_INDEX = UINT32_MAX;
+
+    struct ScopeEvent
+    {
+        // Must be a string with static storage, only the pointer is kept
+        const char* name;
+        uint64_t startTicks;
+        uint64_t endTicks;
+        uint32_t depth;
+        uint32_t threadIndex;
+    };
+
+    // Time spent in one scope name during a frame, nested scopes of the same
+    // name are counted each time
+    struct ScopeSummary
+    {
+        const char* name;
+        uint32_t calls;
+        uint32_t depth;     // depth of the first call
+        double milliseconds;
+    };
+
+    struct FrameSummary
+    {
+        uint64_t frame = 0;
+        std::vector<ScopeSummary> scopes;
+        // GPU scopes that came back during the frame. They were recorded a
+        // few frames earlier, see LlyGpuProfiler.
+        std::vector<ScopeSummary> gpuScopes;
+        // Scopes overwritten before EndFrame got to them
+        uint64_t lostEvents = 0;
+        // Scopes skipped for nesting deeper than the profiler tracks
+        uint64_t droppedScopes = 0;
+    };
+
+    static void BeginScope(const char* name);
+    static void EndScope();
+
+    // Main thread only. Adds a scope measured on the GPU, its ticks already
+    // converted to the CPU clock. It is collected by the next EndFrame.
+    static void AddGpuScope(const char* name, uint64_t startTicks, uint64_t endTicks, uint32_t depth);
+
+    // Main thread, once per frame
+    static void EndFrame();
+    static const FrameSummary& GetLastFrame() { return lastFrame; }
+
+    // Keep every scope collected from now on until EndCapture writes them as
+    // Chrome trace-event JSON. Returns false if the file couldn't be written.
+    static void BeginCapture();
+    static bool EndCapture(const std::string& path);
+    static bool IsCapturing() { return capturing; }
+
+private:
+    struct ThreadBuffer
+    {
+        ScopeEvent events[EVENTS_PER_THREAD];
+        // Written by the owning thread only, read by EndFrame
+        std::atomic<uint64_t> head{0};
+        uint64_t collected = 0;     // touched by EndFrame only
+
+        // Open scopes of the owning thread
+        static constexpr uint32_t MAX_DEPTH = 64;
+        uint64_t openTicks[MAX_DEPTH];
+        const char* openNames[MAX_DEPTH];
+        // Counts dropped scopes too, can go past MAX_DEPTH
+        uint32_t depth = 0;
+        // Scopes nested past MAX_DEPTH, written by the owning thread only
+        std::atomic<uint64_t> dropped{0};
+        uint64_t droppedCollected = 0;  // touched by EndFrame only
+
+        // Kept when the buffer passes to a new thread, threads that reused
+        // it one after the other share a track in the trace
+        uint32_t threadIndex = 0;
+        ThreadBuffer* next = nullptr;
+        ThreadBuffer* nextFree = nullptr;
+    };
+
+    // Gives the buffer back when its thread exits
+    struct ThreadBufferOwner
+    {
+        ThreadBuffer* buffer = AcquireThreadBuffer();
+        ~ThreadBufferOwner() { ReleaseThreadBuffer(buffer); }
+    };
+
+    static ThreadBuffer& GetThreadBuffer()
+    {
+        thread_local ThreadBufferOwner owner;
+        return *owner.buffer;
+    }
+
+    static ThreadBuffer* AcquireThreadBuffer();
+    static void ReleaseThreadBuffer(ThreadBuffer* buffer);
+    static void Summarize(std::vector<ScopeSummary>& scopes, const ScopeEvent& event, double ticksPerMillisecond);
+
+    static std::atomic<ThreadBuffer*> threadBuffers;
+    // Buffers of threads that exited, guarded by a mutex in Profiler.cpp
+    static ThreadBuffer* freeBuffers;
+    static FrameSummary lastFrame;
+    static std::vector<ScopeEvent> gpuEvents;
+    static std::vector<ScopeEvent> capture;
+    static bool capturing;
+};
+
+class ProfileScope
+{
+public:
+    inline explicit ProfileScope(const char* name) { Profiler::BeginScope(name); }
+    inline ~ProfileScope() { Profiler::EndScope(); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+} // namespace ember
+
+// Turned on by the EM_ENABLE_PROFILER build option, otherwise the macros
+// disappear and nothing is recorded
+#ifdef EM_ENABLE_PROFILER
+    #define EM_PROFILE_CONCAT_IMPL(a, b) a##b
+    #define EM_PROFILE_CONCAT(a, b) EM_PROFILE_CONCAT_IMPL(a, b)
+    #define EM_PROFILE_SCOPE(name) ::ember::ProfileScope EM_PROFILE_CONCAT(emProfileScope_, __LINE__)(name)
+    #define EM_PROFILE_FUNCTION() EM_PROFILE_SCOPE(__FUNCTION__)
+    #define EM_PROFILE_END_FRAME() ::ember::Profiler::EndFrame()
+#else
+    #define EM_PROFILE_SCOPE(name)
+    #define EM_PROFILE_FUNCTION()
+    #define EM_PROFILE_END_FRAME()
+#endif
@@ -1,7 +1,13 @@
 #pragma once
 
+#include "Core/Allocators.hpp"
 #include "Core/Asserts.hpp"
 #include "Core/Application.hpp"
+#include "Core/FiberScheduler.hpp"
+#include "Core/Input.hpp"
+#include "Core/JobSystem.hpp"
+#include "Core/MemoryTracker.hpp"
+#include "Core/Profiler.hpp"
 
 // Disable engine logger for client app
 #undef EM_LOG_TRACE
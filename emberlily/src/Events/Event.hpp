@@ -1,13 +1,14 @@
 #pragma once
 
+#include <cstddef>
+#include <ostream>
 #include <string>
 #include "Core/Defines.hpp"
 
 namespace ember {
-	// Events are currently blocking, meaning when an event occurs it
-	// immediately gets dispatched and must be dealt with rigth then and there.
-	// For the future, a better strategy might be to buffer events in an event
-	// bus and process them during the "event" part of the update stage.
+	// Events coming from the window are not dispatched from inside the GLFW
+	// callbacks. They are buffered in the window's EventQueue and processed in
+	// one batch during the "event" part of the update stage (see Application::Run).
 
 	enum class EventType
 	{
@@ -18,6 +19,9 @@ namespace ember {
 		MouseButtonPressed, MouseButtonReleased, MouseMoved, MouseScrolled
 	};
 
+	// Number of event types, used to size tables indexed by EventType
+	constexpr size_t EventTypeCount = static_cast<size_t>(EventType::MouseScrolled) + 1;
+
 	enum EventCategory
 	{
 		None = 0,
@@ -28,7 +32,7 @@ namespace ember {
 		EventCategoryMouseButton  = BIT(4)
 	};
 
-	#define EVENT_CLASS_TYPE(type) static EventType GetStaticType() { return EventType::##type; }\
+	#define EVENT_CLASS_TYPE(type) static EventType GetStaticType() { return EventType::type; }\
 								   virtual EventType GetEventType() const override { return GetStaticType(); }\
 								   virtual const char* GetName() const override { return #type; }
 
@@ -37,6 +41,7 @@ namespace ember {
 	class Event
 	{
 		friend class EventDispatcher;
+		friend class EventHandlerTable;
 
 	public:
 		virtual EventType GetEventType() const = 0;
@@ -59,14 +64,13 @@ namespace ember {
 
 	class EventDispatcher
 	{
-		template<typename T>
-		using EventFn = std::function<bool(T&)>;
 	public:
 		EventDispatcher(Event& event)
 			: event_(event) {}
 
-		template<typename T>
-		bool Dispatch(EventFn<T> func)
+		// F is any callable taking T&, taken as is so no std::function is built
+		template<typename T, typename F>
+		bool Dispatch(const F& func)
 		{
 			if (event_.GetEventType() == T::GetStaticType())
 			{
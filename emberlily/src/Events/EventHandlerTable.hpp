@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "Event.hpp"
+
+namespace ember {
+
+	// Handlers registered once per event type. Dispatching an event is an index
+	// into the table and a single call through a plain function pointer, no
+	// std::function is built and nothing is allocated.
+	class EventHandlerTable
+	{
+	public:
+		// Registers instance->*Method as the handler of events of type T,
+		// replacing any previous handler of that type
+		template<typename T, typename C, bool (C::*Method)(T&)>
+		void Register(C* instance)
+		{
+			Entry& entry = handlers_[Index(T::GetStaticType())];
+			entry.instance = instance;
+			entry.fn = [](void* self, Event& event) -> bool
+			{
+				return (static_cast<C*>(self)->*Method)(static_cast<T&>(event));
+			};
+		}
+
+		template<typename T>
+		void Unregister()
+		{
+			handlers_[Index(T::GetStaticType())] = Entry{};
+		}
+
+		// Dispatch with the event type known at compile time
+		template<typename T>
+		bool Dispatch(T& event) const
+		{
+			return Invoke(handlers_[Index(T::GetStaticType())], event);
+		}
+
+		// Dispatch of an event only known through its base class
+		bool Dispatch(Event& event) const
+		{
+			return Invoke(handlers_[Index(event.GetEventType())], event);
+		}
+
+	private:
+		struct Entry
+		{
+			bool (*fn)(void*, Event&) = nullptr;
+			void* instance = nullptr;
+		};
+
+		static constexpr size_t Index(EventType type) { return static_cast<size_t>(type); }
+
+		static bool Invoke(const Entry& entry, Event& event)
+		{
+			if (!entry.fn)
+				return false;
+
+			event.handled_ = entry.fn(entry.instance, event);
+			return true;
+		}
+
+		std::array<Entry, EventTypeCount> handlers_{};
+	};
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Event.hpp"
+#include "ApplicationEvent.hpp"
+#include "KeyEvent.hpp"
+#include "MouseEvent.hpp"
+
+namespace ember {
+
+	// Plain copy of an event's data, small enough to be stored by value in the
+	// queue without any allocation.
+	struct QueuedEvent
+	{
+		QueuedEvent()
+			: payload{} {}
+		explicit QueuedEvent(EventType eventType)
+			: type(eventType), payload{} {}
+
+		EventType type = EventType::None;
+		union Payload
+		{
+			struct { unsigned int width, height; } window;
+			struct { KeyCode keyCode; } key;
+			struct { int button; } mouseButton;
+			struct { float x, y; } mouse;
+		} payload;
+
+		static QueuedEvent WindowResize(unsigned int width, unsigned int height)
+		{
+			QueuedEvent e(EventType::WindowResize);
+			e.payload.window.width = width;
+			e.payload.window.height = height;
+			return e;
+		}
+
+		static QueuedEvent WindowClose() { return QueuedEvent(EventType::WindowClose); }
+
+		static QueuedEvent Key(EventType type, KeyCode keyCode)
+		{
+			QueuedEvent e(type);
+			e.payload.key.keyCode = keyCode;
+			return e;
+		}
+
+		static QueuedEvent MouseButton(EventType type, int button)
+		{
+			QueuedEvent e(type);
+			e.payload.mouseButton.button = button;
+			return e;
+		}
+
+		static QueuedEvent Mouse(EventType type, float x, float y)
+		{
+			QueuedEvent e(type);
+			e.payload.mouse.x = x;
+			e.payload.mouse.y = y;
+			return e;
+		}
+	};
+
+	// Fixed-capacity ring buffer the window callbacks push into. The queue is
+	// drained once per frame, which rebuilds every event on the stack and hands
+	// it to the handler in one batch.
+	//
+	// Pushing and draining both happen on the main thread (GLFW only calls
+	// back from glfwPollEvents/glfwWaitEvents), so no synchronization is needed.
+	class EventQueue
+	{
+	public:
+		static constexpr uint32_t CAPACITY = 256;
+		static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Event queue capacity must be a power of 2");
+
+		// Returns false and drops the event when the queue is full
+		bool Push(const QueuedEvent& event)
+		{
+			if (coalesce_ && Coalesce(event))
+				return true;
+
+			if (tail_ - head_ == CAPACITY)
+			{
+				dropped_++;
+				return false;
+			}
+
+			events_[tail_ & (CAPACITY - 1)] = event;
+			tail_++;
+			return true;
+		}
+
+		// Dispatches every event queued so far to handler(Event&). Events queued
+		// while draining are left for the next drain.
+		template<typename F>
+		uint32_t Drain(F&& handler)
+		{
+			const uint32_t end = tail_;
+			uint32_t count = 0;
+
+			while (head_ != end)
+			{
+				const QueuedEvent event = events_[head_ & (CAPACITY - 1)];
+				head_++;
+				count++;
+
+				Dispatch(event, handler);
+			}
+
+			return count;
+		}
+
+		// Merge a MouseMoved/MouseScrolled event into the one queued right before
+		// it when both have the same type. Enabled by default, turn it off to get
+		// every cursor sample the OS reports.
+		inline void SetCoalescing(bool enabled) { coalesce_ = enabled; }
+		inline bool IsCoalescing() const { return coalesce_; }
+
+		inline uint32_t Size() const { return tail_ - head_; }
+		inline bool IsEmpty() const { return tail_ == head_; }
+		// Number of events lost because the queue was full
+		inline uint64_t GetDroppedCount() const { return dropped_; }
+		// Number of events merged into an already queued one
+		inline uint64_t GetCoalescedCount() const { return coalesced_; }
+
+	private:
+		bool Coalesce(const QueuedEvent& event)
+		{
+			if (tail_ == head_)
+				return false;
+
+			QueuedEvent& last = events_[(tail_ - 1) & (CAPACITY - 1)];
+			if (last.type != event.type)
+				return false;
+
+			switch (event.type)
+			{
+			case EventType::MouseMoved:
+				// Positions are absolute, only the latest one matters
+				last.payload.mouse = event.payload.mouse;
+				break;
+			case EventType::MouseScrolled:
+				// Offsets are deltas, add them up
+				last.payload.mouse.x += event.payload.mouse.x;
+				last.payload.mouse.y += event.payload.mouse.y;
+				break;
+			default:
+				return false;
+			}
+
+			coalesced_++;
+			return true;
+		}
+
+		template<typename F>
+		static void Dispatch(const QueuedEvent& e, F& handler)
+		{
+			switch (e.type)
+			{
+			case EventType::WindowClose: { WindowCloseEvent event; handler(event); break; }
+			case EventType::WindowResize: { WindowResizeEvent event(e.payload.window.width, e.payload.window.height); handler(event); break; }
+			case EventType::KeyPressed: { KeyPressedEvent event(e.payload.key.keyCode); handler(event); break; }
+			case EventType::KeyRepeat: { KeyRepeatEvent event(e.payload.key.keyCode); handler(event); break; }
+			case EventType::KeyReleased: { KeyReleasedEvent event(e.payload.key.keyCode); handler(event); break; }
+			case EventType::MouseButtonPressed: { MouseButtonPressedEvent event(e.payload.mouseButton.button); handler(event); break; }
+			case EventType::MouseButtonReleased: { MouseButtonReleasedEvent event(e.payload.mouseButton.button); handler(event); break; }
+			case EventType::MouseMoved: { MouseMovedEvent event(e.payload.mouse.x, e.payload.mouse.y); handler(event); break; }
+			case EventType::MouseScrolled: { MouseScrolledEvent event(e.payload.mouse.x, e.payload.mouse.y); handler(event); break; }
+			default: break;
+			}
+		}
+
+		QueuedEvent events_[CAPACITY];
+		// Free running counters, wrapped into the buffer with the capacity mask
+		uint32_t head_ = 0;
+		uint32_t tail_ = 0;
+		uint64_t dropped_ = 0;
+		uint64_t coalesced_ = 0;
+		bool coalesce_ = true;
+	};
+
+}
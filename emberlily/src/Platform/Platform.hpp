@@ -1,27 +1,62 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
 
+#include "Core/Defines.hpp"
+
 namespace ember
 {
-    
-void* platformAllocate(unsigned long long size, bool aligend)
+
+// Alignment of platformAllocate(size, true), one cache line
+constexpr size_t PLATFORM_DEFAULT_ALIGNMENT = 64;
+
+// alignment must be a power of two. Free the block with platformFreeAligned.
+inline void* platformAllocateAligned(unsigned long long size, size_t alignment)
 {
-    return malloc(size);
+    if (alignment < sizeof(void*))
+        alignment = sizeof(void*);
+    // Rounded up so aligned_alloc style implementations accept it too
+    size = (size + alignment - 1) & ~static_cast<unsigned long long>(alignment - 1);
+
+#ifdef EM_PLATFORM_WINDOWS
+    return _aligned_malloc(size, alignment);
+#else
+    void* block = nullptr;
+    return posix_memalign(&block, alignment, size) == 0 ? block : nullptr;
+#endif
 }
 
-void platformFree(void* block, bool aligned)
+inline void platformFreeAligned(void* block)
 {
+#ifdef EM_PLATFORM_WINDOWS
+    _aligned_free(block);
+#else
     free(block);
+#endif
+}
+
+inline void* platformAllocate(unsigned long long size, bool aligned)
+{
+    return aligned ? platformAllocateAligned(size, PLATFORM_DEFAULT_ALIGNMENT) : malloc(size);
+}
+
+// aligned must match the flag the block was allocated with
+inline void platformFree(void* block, bool aligned)
+{
+    if (aligned)
+        platformFreeAligned(block);
+    else
+        free(block);
 }
 
-void* platformZeroMemory(void* block, unsigned long long size)
+inline void* platformZeroMemory(void* block, unsigned long long size)
 {
     return memset(block, 0, size);
 }
 
-void* platformSetMemory(void* dest, int value, unsigned long long size)
+inline void* platformSetMemory(void* dest, int value, unsigned long long size)
 {
     return memset(dest, value, size);
 }
@@ -0,0 +1,445 @@
+#include "LlyAssetStreamer.hpp"
+
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+#include "Core/Asserts.hpp"
+#include "Core/MappedFile.hpp"
+#include "Core/Profiler.hpp"
+
+namespace ember
+{
+
+// Every ring allocation starts on this boundary, more than any copy needs
+static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+static VkDeviceSize alignStaging(VkDeviceSize size)
+{
+    return (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+}
+
+LlyAssetStreamer::LlyAssetStreamer(std::shared_ptr<LlyDevice> device, const Config& config)
+    : device_(device)
+{
+    stagingSize_ = alignStaging(config.stagingSize > 0 ? config.stagingSize : DEFAULT_STAGING_SIZE);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = device_->transferQueueFamily();
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    VkResult ok = vkCreateCommandPool(device_->device(), &poolInfo, nullptr, &commandPool_);
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Could not create transfer command pool!");
+
+    for (uint32_t i = 0; i < MAX_BATCHES_IN_FLIGHT; i++) {
+        Batch& batch = batches_[i];
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool_;
+        allocInfo.commandBufferCount = 1;
+        ok = vkAllocateCommandBuffers(device_->device(), &allocInfo, &batch.commandBuffer);
+        if (ok != VK_SUCCESS)
+            throw std::runtime_error("Could not allocate transfer command buffer!");
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        ok = vkCreateFence(device_->device(), &fenceInfo, nullptr, &batch.fence);
+        if (ok != VK_SUCCESS)
+            throw std::runtime_error("Could not create transfer fence!");
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        ok = vkCreateSemaphore(device_->device(), &semaphoreInfo, nullptr, &batch.semaphore);
+        if (ok != VK_SUCCESS)
+            throw std::runtime_error("Could not create transfer semaphore!");
+
+        freeBatches_.push_back(MAX_BATCHES_IN_FLIGHT - 1 - i);
+    }
+
+    device_->createBuffer(
+        stagingSize_,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer_,
+        stagingMemory_,
+        MemoryTag::Streaming);
+    void* data;
+    ok = vkMapMemory(device_->device(), stagingMemory_, 0, stagingSize_, 0, &data);
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Could not map the staging ring!");
+    stagingData_ = static_cast<uint8_t*>(data);
+
+    const uint32_t threadCount = config.ioThreads > 0 ? config.ioThreads : 1;
+    for (uint32_t i = 0; i < threadCount; i++)
+        ioThreads_.emplace_back(&LlyAssetStreamer::ioThreadMain, this);
+
+    EM_LOG_INFO(
+        "Asset streaming on {0} I/O threads, {1} MB staging, {2}",
+        threadCount,
+        stagingSize_ / (1024 * 1024),
+        device_->hasDedicatedTransferFamily() ? "transfer queue family" : "graphics queue family");
+}
+
+LlyAssetStreamer::~LlyAssetStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(requestMutex_);
+        stopping_ = true;
+        for (const auto& request : requests_)
+            fail(request);
+        requests_.clear();
+    }
+    requestCondition_.notify_all();
+    {
+        // Wakes I/O threads waiting for ring space, they give up
+        std::lock_guard<std::mutex> lock(ringMutex_);
+    }
+    ringCondition_.notify_all();
+
+    for (auto& thread : ioThreads_)
+        thread.join();
+
+    retireBatches(true);
+
+    // Staged but never submitted, the models go without being drawn
+    for (const auto& upload : staged_)
+        fail(upload.request);
+    for (const auto& upload : batchUploads_)
+        fail(upload.request);
+    staged_.clear();
+    batchUploads_.clear();
+
+    for (Batch& batch : batches_) {
+        vkDestroySemaphore(device_->device(), batch.semaphore, nullptr);
+        vkDestroyFence(device_->device(), batch.fence, nullptr);
+    }
+    vkDestroyCommandPool(device_->device(), commandPool_, nullptr);
+
+    vkUnmapMemory(device_->device(), stagingMemory_);
+    vkDestroyBuffer(device_->device(), stagingBuffer_, nullptr);
+    device_->freeMemory(stagingMemory_);
+}
+
+std::shared_ptr<LlyAssetStreamer::StreamedModel> LlyAssetStreamer::loadModel(const std::string& path)
+{
+    auto request = std::make_shared<StreamedModel>();
+    request->path = path;
+    requested_.fetch_add(1, std::memory_order_relaxed);
+    pending_.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(requestMutex_);
+        if (stopping_) {
+            fail(request);
+            return request;
+        }
+        requests_.push_back(request);
+    }
+    requestCondition_.notify_one();
+    return request;
+}
+
+LlyAssetStreamer::Stats LlyAssetStreamer::getStats() const
+{
+    Stats stats = stats_;
+    stats.requested = requested_.load(std::memory_order_relaxed);
+    stats.failed = failed_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void LlyAssetStreamer::fail(const std::shared_ptr<StreamedModel>& request)
+{
+    request->state.store(State::Failed, std::memory_order_release);
+    failed_.fetch_add(1, std::memory_order_relaxed);
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void LlyAssetStreamer::ioThreadMain()
+{
+    for (;;) {
+        std::shared_ptr<StreamedModel> request;
+        {
+            std::unique_lock<std::mutex> lock(requestMutex_);
+            requestCondition_.wait(lock, [this] { return stopping_ || !requests_.empty(); });
+            if (stopping_)
+                return;
+            request = std::move(requests_.front());
+            requests_.pop_front();
+        }
+
+        stage(request);
+    }
+}
+
+void LlyAssetStreamer::stage(const std::shared_ptr<StreamedModel>& request)
+{
+    EM_PROFILE_FUNCTION();
+
+    const char* path = request->path.c_str();
+    MappedFile file;
+    if (!file.Open(path)) {
+        EM_LOG_ERROR("Could not open mesh file {0}", path);
+        fail(request);
+        return;
+    }
+
+    LlyModel::MeshData mesh;
+    if (!LlyModel::readMeshFile(file.GetData(), file.GetSize(), path, mesh)) {
+        fail(request);
+        return;
+    }
+
+    StagedUpload upload;
+    upload.request = request;
+    upload.vertexBytes = LlyModel::vertexBytes(mesh);
+    upload.indexBytes = LlyModel::indexBytes(mesh);
+
+    VkDeviceSize offset;
+    const VkDeviceSize vertexSpace = alignStaging(upload.vertexBytes);
+    if (!allocateStaging(vertexSpace + upload.indexBytes, offset, upload.allocation)) {
+        if (!stopping_) {
+            EM_LOG_ERROR(
+                "{0} needs {1} bytes of staging, more than the {2} the streamer has",
+                path,
+                vertexSpace + upload.indexBytes,
+                stagingSize_);
+        }
+        fail(request);
+        return;
+    }
+    upload.vertexOffset = offset;
+    upload.indexOffset = offset + vertexSpace;
+
+    // Reading the mapping is where the file is actually read
+    std::memcpy(stagingData_ + upload.vertexOffset, mesh.vertices, static_cast<size_t>(upload.vertexBytes));
+    if (upload.indexBytes > 0)
+        std::memcpy(stagingData_ + upload.indexOffset, mesh.indices, static_cast<size_t>(upload.indexBytes));
+
+    try {
+        upload.model = LlyModel::createForUpload(device_, mesh);
+    } catch (const std::exception& e) {
+        EM_LOG_ERROR("Could not create the buffers for {0}: {1}", path, e.what());
+        releaseStaging(upload.allocation);
+        fail(request);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(stagedMutex_);
+    staged_.push_back(std::move(upload));
+}
+
+bool LlyAssetStreamer::allocateStaging(VkDeviceSize size, VkDeviceSize& offset, uint64_t& allocation)
+{
+    size = alignStaging(size);
+    if (size > stagingSize_)
+        return false;
+
+    std::unique_lock<std::mutex> lock(ringMutex_);
+
+    // Space at the head, or at the start of the ring with the rest of the
+    // end skipped when it doesn't fit there
+    VkDeviceSize padding = 0;
+    auto fits = [&]() {
+        offset = ringHead_;
+        padding = 0;
+        if (offset + size > stagingSize_) {
+            padding = stagingSize_ - offset;
+            offset = 0;
+        }
+        return ringUsed_ + padding + size <= stagingSize_;
+    };
+
+    ringCondition_.wait(lock, [&] { return stopping_ || fits(); });
+    if (stopping_)
+        return false;
+
+    allocation = firstAllocation_ + ringAllocations_.size();
+    ringAllocations_.push_back({padding + size, false});
+    ringHead_ = offset + size;
+    ringUsed_ += padding + size;
+    return true;
+}
+
+void LlyAssetStreamer::releaseStaging(uint64_t allocation)
+{
+    {
+        std::lock_guard<std::mutex> lock(ringMutex_);
+        ringAllocations_[allocation - firstAllocation_].released = true;
+
+        while (!ringAllocations_.empty() && ringAllocations_.front().released) {
+            ringUsed_ -= ringAllocations_.front().size;
+            ringAllocations_.pop_front();
+            firstAllocation_++;
+        }
+        // An empty ring starts over, big uploads don't have to wrap
+        if (ringUsed_ == 0)
+            ringHead_ = 0;
+    }
+    ringCondition_.notify_all();
+}
+
+void LlyAssetStreamer::retireBatches(bool wait)
+{
+    while (!batchesInFlight_.empty()) {
+        const uint32_t index = batchesInFlight_.front();
+        Batch& batch = batches_[index];
+
+        if (wait)
+            vkWaitForFences(device_->device(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        else if (vkGetFenceStatus(device_->device(), batch.fence) != VK_SUCCESS)
+            break;
+
+        for (uint64_t allocation : batch.allocations)
+            releaseStaging(allocation);
+        batch.allocations.clear();
+
+        freeBatches_.push_back(index);
+        batchesInFlight_.pop_front();
+    }
+}
+
+void LlyAssetStreamer::beginFrame()
+{
+    EM_PROFILE_FUNCTION();
+
+    frameSemaphore_ = VK_NULL_HANDLE;
+    pendingAcquires_.clear();
+
+    retireBatches(false);
+
+    {
+        std::lock_guard<std::mutex> lock(stagedMutex_);
+        for (auto& upload : staged_)
+            batchUploads_.push_back(std::move(upload));
+        staged_.clear();
+    }
+    if (batchUploads_.empty())
+        return;
+    if (freeBatches_.empty()) {
+        stats_.framesBatchLimited++;
+        return;
+    }
+
+    const uint32_t index = freeBatches_.back();
+    freeBatches_.pop_back();
+    Batch& batch = batches_[index];
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VkResult ok = vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Failed to begin recording transfer command buffer!");
+
+    // Without a family of its own the semaphore is all the graphics queue
+    // needs, otherwise ownership is released here and acquired by the frame
+    const bool transferOwnership = device_->hasDedicatedTransferFamily();
+    std::vector<VkBufferMemoryBarrier> releases;
+
+    for (const auto& upload : batchUploads_) {
+        const VkBuffer vertexBuffer = upload.model->getVertexBuffer();
+        const VkBuffer indexBuffer = upload.model->getIndexBuffer();
+
+        VkBufferCopy vertexCopy{upload.vertexOffset, 0, upload.vertexBytes};
+        vkCmdCopyBuffer(batch.commandBuffer, stagingBuffer_, vertexBuffer, 1, &vertexCopy);
+        pendingAcquires_.push_back(vertexBuffer);
+        if (upload.indexBytes > 0) {
+            VkBufferCopy indexCopy{upload.indexOffset, 0, upload.indexBytes};
+            vkCmdCopyBuffer(batch.commandBuffer, stagingBuffer_, indexBuffer, 1, &indexCopy);
+            pendingAcquires_.push_back(indexBuffer);
+        }
+        batch.allocations.push_back(upload.allocation);
+        stats_.bytesUploaded += upload.vertexBytes + upload.indexBytes;
+    }
+
+    if (transferOwnership) {
+        for (VkBuffer buffer : pendingAcquires_) {
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+            barrier.srcQueueFamilyIndex = device_->transferQueueFamily();
+            barrier.dstQueueFamilyIndex = device_->graphicsQueueFamily();
+            barrier.buffer = buffer;
+            barrier.offset = 0;
+            barrier.size = VK_WHOLE_SIZE;
+            releases.push_back(barrier);
+        }
+        vkCmdPipelineBarrier(
+            batch.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0, nullptr,
+            static_cast<uint32_t>(releases.size()), releases.data(),
+            0, nullptr);
+    } else {
+        pendingAcquires_.clear();
+    }
+
+    ok = vkEndCommandBuffer(batch.commandBuffer);
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Failed to end recording transfer command buffer!");
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &batch.semaphore;
+
+    vkResetFences(device_->device(), 1, &batch.fence);
+    ok = vkQueueSubmit(device_->transferQueue(), 1, &submitInfo, batch.fence);
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit transfer command buffer!");
+
+    batchesInFlight_.push_back(index);
+    frameSemaphore_ = batch.semaphore;
+    stats_.batchesSubmitted++;
+
+    // Drawable from this frame on, its submit waits for the copies
+    for (auto& upload : batchUploads_) {
+        upload.request->model = std::move(upload.model);
+        upload.request->state.store(State::Ready, std::memory_order_release);
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        stats_.uploaded++;
+        EM_LOG_DEBUG("Streamed {0}", upload.request->path);
+    }
+    batchUploads_.clear();
+}
+
+void LlyAssetStreamer::recordAcquireBarriers(VkCommandBuffer commandBuffer)
+{
+    if (pendingAcquires_.empty())
+        return;
+
+    std::vector<VkBufferMemoryBarrier> acquires;
+    for (VkBuffer buffer : pendingAcquires_) {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+        barrier.srcQueueFamilyIndex = device_->transferQueueFamily();
+        barrier.dstQueueFamilyIndex = device_->graphicsQueueFamily();
+        barrier.buffer = buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        acquires.push_back(barrier);
+    }
+
+    // Chained to the semaphore wait, which happens at vertex input too
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0,
+        0, nullptr,
+        static_cast<uint32_t>(acquires.size()), acquires.data(),
+        0, nullptr);
+    pendingAcquires_.clear();
+}
+
+} // namespace ember
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "LlyDevice.hpp"
+#include "LlyModel.hpp"
+
+namespace ember
+{
+
+// Loads .emesh files in the background without stalling frames. I/O threads
+// map the files and copy their blobs into a persistently mapped staging ring,
+// the main thread turns whatever was staged since the last frame into one
+// batch of copies on the device's transfer queue. The frame that follows
+// waits on the batch's semaphore at vertex input, so the copies overlap the
+// previous frames instead of blocking the graphics queue, and the model can
+// be drawn in that same frame.
+//
+// With a transfer only queue family the buffers are released by the transfer
+// queue and acquired by the graphics queue in the frame's command buffer.
+// Ring space comes back once a batch's fence has signaled, an I/O thread
+// waits when the ring is full.
+class LlyAssetStreamer
+{
+public:
+    static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32 * 1024 * 1024;
+    // Batches on the transfer queue at once, more staged data waits a frame
+    static constexpr uint32_t MAX_BATCHES_IN_FLIGHT = 4;
+
+    struct Config
+    {
+        // 0 uses one
+        uint32_t ioThreads = 0;
+        // Bytes of the staging ring, 0 uses DEFAULT_STAGING_SIZE. A mesh
+        // bigger than the ring can't be streamed.
+        VkDeviceSize stagingSize = 0;
+    };
+
+    enum class State : uint32_t
+    {
+        Pending,
+        Ready,
+        Failed
+    };
+
+    // A model on its way to the GPU. model is set on the main thread by
+    // beginFrame, from then on it can be drawn.
+    struct StreamedModel
+    {
+        std::string path;
+        std::atomic<State> state{State::Pending};
+        std::shared_ptr<LlyModel> model;
+
+        bool isReady() const { return state.load(std::memory_order_acquire) == State::Ready; }
+    };
+
+    struct Stats
+    {
+        uint64_t requested = 0;
+        uint64_t uploaded = 0;
+        uint64_t failed = 0;
+        uint64_t bytesUploaded = 0;
+        uint64_t batchesSubmitted = 0;
+        // Frames that had staged data left over because every batch was in flight
+        uint64_t framesBatchLimited = 0;
+    };
+
+    LlyAssetStreamer(std::shared_ptr<LlyDevice> device, const Config& config);
+    // Cancels what hasn't been staged yet and waits for the transfer queue
+    ~LlyAssetStreamer();
+
+    LlyAssetStreamer(const LlyAssetStreamer&) = delete;
+    LlyAssetStreamer& operator=(const LlyAssetStreamer&) = delete;
+
+    // Queues a .emesh file, can be called from any thread. The returned
+    // request becomes Ready or Failed in a later beginFrame.
+    std::shared_ptr<StreamedModel> loadModel(const std::string& path);
+
+    // Main thread, once per frame after the swapchain image was acquired and
+    // before the frame is recorded. Retires finished batches and submits
+    // everything staged since the last call to the transfer queue.
+    void beginFrame();
+    // Records the graphics queue's side of the ownership transfer for the
+    // batch beginFrame submitted, outside of a render pass. Nothing to do on
+    // a shared queue family.
+    void recordAcquireBarriers(VkCommandBuffer commandBuffer);
+    // Semaphore the frame's submit has to wait on at vertex input,
+    // VK_NULL_HANDLE when beginFrame had nothing to submit
+    VkSemaphore getFrameSemaphore() const { return frameSemaphore_; }
+
+    // Requests not Ready or Failed yet
+    uint32_t getPendingCount() const { return pending_.load(std::memory_order_relaxed); }
+    Stats getStats() const;
+
+private:
+    // A mesh copied into the ring, waiting for the next batch
+    struct StagedUpload
+    {
+        std::shared_ptr<StreamedModel> request;
+        std::unique_ptr<LlyModel> model;
+        uint64_t allocation;
+        VkDeviceSize vertexOffset;
+        VkDeviceSize vertexBytes;
+        VkDeviceSize indexOffset;
+        VkDeviceSize indexBytes;
+    };
+
+    struct Batch
+    {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        // Ring allocations freed once the fence signals
+        std::vector<uint64_t> allocations;
+    };
+
+    struct RingAllocation
+    {
+        VkDeviceSize size;
+        bool released;
+    };
+
+    void ioThreadMain();
+    void stage(const std::shared_ptr<StreamedModel>& request);
+    // Blocks until size bytes are free, false if they never will be
+    bool allocateStaging(VkDeviceSize size, VkDeviceSize& offset, uint64_t& allocation);
+    void releaseStaging(uint64_t allocation);
+    void retireBatches(bool wait);
+    void fail(const std::shared_ptr<StreamedModel>& request);
+
+    std::shared_ptr<LlyDevice> device_;
+    VkCommandPool commandPool_ = VK_NULL_HANDLE;
+    VkBuffer stagingBuffer_ = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory_ = VK_NULL_HANDLE;
+    uint8_t* stagingData_ = nullptr;
+    VkDeviceSize stagingSize_ = 0;
+
+    Batch batches_[MAX_BATCHES_IN_FLIGHT];
+    // Indices into batches_ in submission order
+    std::deque<uint32_t> batchesInFlight_;
+    std::vector<uint32_t> freeBatches_;
+    VkSemaphore frameSemaphore_ = VK_NULL_HANDLE;
+    // Buffers the current frame acquires from the transfer family
+    std::vector<VkBuffer> pendingAcquires_;
+
+    std::vector<std::thread> ioThreads_;
+    std::mutex requestMutex_;
+    std::condition_variable requestCondition_;
+    std::deque<std::shared_ptr<StreamedModel>> requests_;
+    std::atomic<bool> stopping_{false};
+
+    // The ring hands out space in order and takes it back in order, a
+    // released allocation is only reclaimed once everything before it is
+    std::mutex ringMutex_;
+    std::condition_variable ringCondition_;
+    std::deque<RingAllocation> ringAllocations_;
+    uint64_t firstAllocation_ = 0;
+    VkDeviceSize ringHead_ = 0;
+    VkDeviceSize ringUsed_ = 0;
+
+    std::mutex stagedMutex_;
+    std::vector<StagedUpload> staged_;
+    // Main thread only, staged uploads beginFrame takes from staged_
+    std::vector<StagedUpload> batchUploads_;
+
+    std::atomic<uint32_t> pending_{0};
+    std::atomic<uint64_t> requested_{0};
+    std::atomic<uint64_t> failed_{0};
+    // The rest of the stats, main thread only
+    Stats stats_;
+};
+
+} // namespace ember
@@ -0,0 +1,172 @@
+#include "LlyCommandRecorder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Core/Asserts.hpp"
+
+namespace ember
+{
+
+void LlyCommandRecorder::begin(VkCommandBuffer commandBuffer)
+{
+    commandBuffer_ = commandBuffer;
+    stats_ = Stats{};
+    invalidate();
+}
+
+void LlyCommandRecorder::invalidate()
+{
+    graphicsPipeline_ = VK_NULL_HANDLE;
+    validVertexBindings_ = 0;
+    indexBuffer_ = VK_NULL_HANDLE;
+    viewportValid_ = false;
+    scissorValid_ = false;
+    pushLayout_ = VK_NULL_HANDLE;
+    pushStages_ = 0;
+    pushValidBegin_ = 0;
+    pushValidEnd_ = 0;
+}
+
+void LlyCommandRecorder::bindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline)
+{
+    if (bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+        if (pipeline == graphicsPipeline_) {
+            stats_.pipelineBindsElided++;
+            return;
+        }
+        graphicsPipeline_ = pipeline;
+    }
+
+    vkCmdBindPipeline(commandBuffer_, bindPoint, pipeline);
+    stats_.pipelineBinds++;
+}
+
+void LlyCommandRecorder::bindVertexBuffers(
+    uint32_t firstBinding,
+    uint32_t bindingCount,
+    const VkBuffer* buffers,
+    const VkDeviceSize* offsets)
+{
+    EM_CORE_ASSERT(firstBinding + bindingCount <= MAX_VERTEX_BINDINGS, "Too many vertex bindings to track");
+
+    bool redundant = true;
+    for (uint32_t i = 0; i < bindingCount && redundant; i++) {
+        const uint32_t binding = firstBinding + i;
+        redundant = (validVertexBindings_ & (1u << binding)) &&
+                    vertexBuffers_[binding] == buffers[i] &&
+                    vertexOffsets_[binding] == offsets[i];
+    }
+
+    if (redundant) {
+        stats_.vertexBufferBindsElided++;
+        return;
+    }
+
+    for (uint32_t i = 0; i < bindingCount; i++) {
+        const uint32_t binding = firstBinding + i;
+        vertexBuffers_[binding] = buffers[i];
+        vertexOffsets_[binding] = offsets[i];
+        validVertexBindings_ |= 1u << binding;
+    }
+
+    vkCmdBindVertexBuffers(commandBuffer_, firstBinding, bindingCount, buffers, offsets);
+    stats_.vertexBufferBinds++;
+}
+
+void LlyCommandRecorder::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+    if (buffer == indexBuffer_ && offset == indexOffset_ && indexType == indexType_) {
+        stats_.indexBufferBindsElided++;
+        return;
+    }
+
+    indexBuffer_ = buffer;
+    indexOffset_ = offset;
+    indexType_ = indexType;
+
+    vkCmdBindIndexBuffer(commandBuffer_, buffer, offset, indexType);
+    stats_.indexBufferBinds++;
+}
+
+void LlyCommandRecorder::setViewport(const VkViewport& viewport)
+{
+    if (viewportValid_ && std::memcmp(&viewport_, &viewport, sizeof(VkViewport)) == 0) {
+        stats_.viewportSetsElided++;
+        return;
+    }
+
+    viewport_ = viewport;
+    viewportValid_ = true;
+
+    vkCmdSetViewport(commandBuffer_, 0, 1, &viewport);
+    stats_.viewportSets++;
+}
+
+void LlyCommandRecorder::setScissor(const VkRect2D& scissor)
+{
+    if (scissorValid_ && std::memcmp(&scissor_, &scissor, sizeof(VkRect2D)) == 0) {
+        stats_.scissorSetsElided++;
+        return;
+    }
+
+    scissor_ = scissor;
+    scissorValid_ = true;
+
+    vkCmdSetScissor(commandBuffer_, 0, 1, &scissor);
+    stats_.scissorSets++;
+}
+
+void LlyCommandRecorder::pushConstants(
+    VkPipelineLayout layout,
+    VkShaderStageFlags stageFlags,
+    uint32_t offset,
+    uint32_t size,
+    const void* values)
+{
+    EM_CORE_ASSERT(offset + size <= MAX_PUSH_CONSTANT_SIZE, "Push constant range out of bounds");
+
+    const uint32_t end = offset + size;
+    const bool sameTarget = layout == pushLayout_ && stageFlags == pushStages_;
+
+    if (sameTarget && offset >= pushValidBegin_ && end <= pushValidEnd_ &&
+        std::memcmp(pushData_.data() + offset, values, size) == 0) {
+        stats_.pushConstantWritesElided++;
+        return;
+    }
+
+    // Keep the known range contiguous: grow it when the write touches it,
+    // otherwise start over from the new write
+    if (sameTarget && offset <= pushValidEnd_ && end >= pushValidBegin_) {
+        pushValidBegin_ = std::min(pushValidBegin_, offset);
+        pushValidEnd_ = std::max(pushValidEnd_, end);
+    } else {
+        pushLayout_ = layout;
+        pushStages_ = stageFlags;
+        pushValidBegin_ = offset;
+        pushValidEnd_ = end;
+    }
+    std::memcpy(pushData_.data() + offset, values, size);
+
+    vkCmdPushConstants(commandBuffer_, layout, stageFlags, offset, size, values);
+    stats_.pushConstantWrites++;
+}
+
+void LlyCommandRecorder::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+    vkCmdDraw(commandBuffer_, vertexCount, instanceCount, firstVertex, firstInstance);
+    stats_.draws++;
+}
+
+void LlyCommandRecorder::drawIndexed(
+    uint32_t indexCount,
+    uint32_t instanceCount,
+    uint32_t firstIndex,
+    int32_t vertexOffset,
+    uint32_t firstInstance)
+{
+    vkCmdDrawIndexed(commandBuffer_, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    stats_.draws++;
+}
+
+} // namespace ember
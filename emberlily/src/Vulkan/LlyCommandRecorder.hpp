@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+namespace ember
+{
+
+// Thin wrapper over a command buffer being recorded that remembers the state
+// it has already set and skips commands that wouldn't change anything.
+class LlyCommandRecorder
+{
+public:
+    // Guaranteed minimum of VkPhysicalDeviceLimits::maxPushConstantsSize
+    static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = 128;
+    static constexpr uint32_t MAX_VERTEX_BINDINGS = 8;
+
+    struct Stats
+    {
+        uint32_t pipelineBinds = 0;
+        uint32_t pipelineBindsElided = 0;
+        uint32_t vertexBufferBinds = 0;
+        uint32_t vertexBufferBindsElided = 0;
+        uint32_t indexBufferBinds = 0;
+        uint32_t indexBufferBindsElided = 0;
+        uint32_t viewportSets = 0;
+        uint32_t viewportSetsElided = 0;
+        uint32_t scissorSets = 0;
+        uint32_t scissorSetsElided = 0;
+        uint32_t pushConstantWrites = 0;
+        uint32_t pushConstantWritesElided = 0;
+        uint32_t draws = 0;
+
+        uint32_t totalElided() const
+        {
+            return pipelineBindsElided + vertexBufferBindsElided + indexBufferBindsElided +
+                   viewportSetsElided + scissorSetsElided + pushConstantWritesElided;
+        }
+    };
+
+    LlyCommandRecorder() = default;
+
+    // Delete copy contructors
+    LlyCommandRecorder(const LlyCommandRecorder&) = delete;
+    LlyCommandRecorder& operator=(const LlyCommandRecorder&) = delete;
+
+    // Starts tracking a freshly begun command buffer. Nothing is assumed about
+    // its state and the stats start over.
+    void begin(VkCommandBuffer commandBuffer);
+    // Forget the tracked state, e.g. after recording commands that bypassed
+    // the recorder
+    void invalidate();
+
+    VkCommandBuffer commandBuffer() const { return commandBuffer_; }
+
+    void bindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline);
+    void bindVertexBuffers(
+        uint32_t firstBinding,
+        uint32_t bindingCount,
+        const VkBuffer* buffers,
+        const VkDeviceSize* offsets);
+    void bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+    void setViewport(const VkViewport& viewport);
+    void setScissor(const VkRect2D& scissor);
+    void pushConstants(
+        VkPipelineLayout layout,
+        VkShaderStageFlags stageFlags,
+        uint32_t offset,
+        uint32_t size,
+        const void* values);
+    void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+    void drawIndexed(
+        uint32_t indexCount,
+        uint32_t instanceCount,
+        uint32_t firstIndex,
+        int32_t vertexOffset,
+        uint32_t firstInstance);
+
+    const Stats& getStats() const { return stats_; }
+
+private:
+    VkCommandBuffer commandBuffer_ = VK_NULL_HANDLE;
+    Stats stats_;
+
+    VkPipeline graphicsPipeline_ = VK_NULL_HANDLE;
+
+    std::array<VkBuffer, MAX_VERTEX_BINDINGS> vertexBuffers_{};
+    std::array<VkDeviceSize, MAX_VERTEX_BINDINGS> vertexOffsets_{};
+    uint32_t validVertexBindings_ = 0;  // bitmask of bindings holding a known buffer
+
+    VkBuffer indexBuffer_ = VK_NULL_HANDLE;
+    VkDeviceSize indexOffset_ = 0;
+    VkIndexType indexType_ = VK_INDEX_TYPE_UINT16;
+
+    VkViewport viewport_{};
+    bool viewportValid_ = false;
+    VkRect2D scissor_{};
+    bool scissorValid_ = false;
+
+    // Push constant bytes known to be set, tracked as one contiguous range
+    VkPipelineLayout pushLayout_ = VK_NULL_HANDLE;
+    VkShaderStageFlags pushStages_ = 0;
+    uint32_t pushValidBegin_ = 0;
+    uint32_t pushValidEnd_ = 0;
+    std::array<uint8_t, MAX_PUSH_CONSTANT_SIZE> pushData_{};
+};
+
+} // namespace ember
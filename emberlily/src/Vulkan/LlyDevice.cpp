@@ -1,6 +1,9 @@
 #include "LlyDevice.hpp"
 
+#include "Platform/Platform.hpp"
+
 // std headers
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -46,17 +49,103 @@ void DestroyDebugUtilsMessengerEXT(
   }
 }
 
+static bool instanceExtensionSupported(const char *name) {
+  uint32_t extensionCount = 0;
+  vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> extensions(extensionCount);
+  vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+  for (const auto &extension : extensions) {
+    if (strcmp(extension.extensionName, name) == 0) return true;
+  }
+  return false;
+}
+
+static bool deviceExtensionSupported(VkPhysicalDevice device, const char *name) {
+  uint32_t extensionCount = 0;
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> extensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+  for (const auto &extension : extensions) {
+    if (strcmp(extension.extensionName, name) == 0) return true;
+  }
+  return false;
+}
+
+// Driver host allocations, a header in front of every block remembers what
+// to uncharge when it's freed. pUserData is the MemoryTag.
+struct HostAllocationHeader {
+  size_t size;
+  // from the start of the underlying block to the pointer handed out
+  size_t offset;
+};
+
+static HostAllocationHeader *hostAllocationHeader(void *memory) {
+  return reinterpret_cast<HostAllocationHeader *>(static_cast<char *>(memory) - sizeof(HostAllocationHeader));
+}
+
+static VKAPI_ATTR void *VKAPI_CALL hostAllocate(
+    void *pUserData, size_t size, size_t alignment, VkSystemAllocationScope) {
+  alignment = std::max(alignment, alignof(HostAllocationHeader));
+  const size_t offset = (sizeof(HostAllocationHeader) + alignment - 1) & ~(alignment - 1);
+  char *block = static_cast<char *>(platformAllocateAligned(offset + size, alignment));
+  if (block == nullptr) return nullptr;
+
+  void *memory = block + offset;
+  *hostAllocationHeader(memory) = HostAllocationHeader{size, offset};
+  MemoryTracker::RecordAllocation(
+      MemoryDomain::Cpu, static_cast<MemoryTag>(reinterpret_cast<uintptr_t>(pUserData)), size);
+  return memory;
+}
+
+static VKAPI_ATTR void VKAPI_CALL hostFree(void *pUserData, void *memory) {
+  if (memory == nullptr) return;
+
+  const HostAllocationHeader header = *hostAllocationHeader(memory);
+  platformFreeAligned(static_cast<char *>(memory) - header.offset);
+  MemoryTracker::RecordFree(
+      MemoryDomain::Cpu, static_cast<MemoryTag>(reinterpret_cast<uintptr_t>(pUserData)), header.size);
+}
+
+static VKAPI_ATTR void *VKAPI_CALL hostReallocate(
+    void *pUserData, void *original, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+  if (original == nullptr) return hostAllocate(pUserData, size, alignment, scope);
+  if (size == 0) {
+    hostFree(pUserData, original);
+    return nullptr;
+  }
+
+  void *memory = hostAllocate(pUserData, size, alignment, scope);
+  if (memory == nullptr) return nullptr;
+  memcpy(memory, original, std::min(size, hostAllocationHeader(original)->size));
+  hostFree(pUserData, original);
+  return memory;
+}
+
 // class member functions
 LlyDevice::LlyDevice(std::shared_ptr<LlyWindow> window) : window{window} {
+  if (isHeadless()) {
+    // nothing gets presented
+    deviceExtensions.clear();
+  }
+
   createInstance();
   setupDebugMessenger();
-  createSurface();
+  if (!isHeadless()) {
+    createSurface();
+  }
   pickPhysicalDevice();
   createLogicalDevice();
   createCommandPool();
+  createHostAllocators();
 }
 
 LlyDevice::~LlyDevice() {
+  if (!trackedMemory.empty()) {
+    std::cerr << trackedMemory.size() << " device memory allocations still alive" << std::endl;
+  }
+
   vkDestroyCommandPool(device_, commandPool, nullptr);
   vkDestroyDevice(device_, nullptr);
 
@@ -64,7 +153,9 @@ LlyDevice::~LlyDevice() {
     DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
   }
 
-  vkDestroySurfaceKHR(instance, surface_, nullptr);
+  if (surface_ != VK_NULL_HANDLE) {
+    vkDestroySurfaceKHR(instance, surface_, nullptr);
+  }
   vkDestroyInstance(instance, nullptr);
 }
 
@@ -86,6 +177,11 @@ void LlyDevice::createInstance() {
   createInfo.pApplicationInfo = &appInfo;
 
   auto extensions = getRequiredExtensions();
+  // only needed to query the memory budget, which is optional
+  properties2Supported = instanceExtensionSupported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+  if (properties2Supported) {
+    extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+  }
   createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
   createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -106,6 +202,12 @@ void LlyDevice::createInstance() {
   }
 
   hasGflwRequiredInstanceExtensions();
+
+  if (properties2Supported) {
+    getMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(
+        instance,
+        "vkGetPhysicalDeviceMemoryProperties2KHR");
+  }
 }
 
 void LlyDevice::pickPhysicalDevice() {
@@ -130,27 +232,49 @@ void LlyDevice::pickPhysicalDevice() {
   }
 
   vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
   std::cout << "physical device: " << properties.deviceName << std::endl;
 }
 
 void LlyDevice::createLogicalDevice() {
   QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+  // without a transfer only family, uploads still get a queue of their own
+  // when the graphics family has more than one
+  graphicsFamily_ = indices.graphicsFamily;
+  transferFamily_ = indices.transferFamilyHasValue ? indices.transferFamily : indices.graphicsFamily;
+  const bool secondGraphicsQueue =
+      !indices.transferFamilyHasValue && queueFamilies[indices.graphicsFamily].queueCount > 1;
+
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily, transferFamily_};
 
-  float queuePriority = 1.0f;
+  // uploads are background work, they yield to rendering where priorities matter
+  float queuePriorities[] = {1.0f, 0.5f};
   for (uint32_t queueFamily : uniqueQueueFamilies) {
     VkDeviceQueueCreateInfo queueCreateInfo = {};
     queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     queueCreateInfo.queueFamilyIndex = queueFamily;
-    queueCreateInfo.queueCount = 1;
-    queueCreateInfo.pQueuePriorities = &queuePriority;
+    queueCreateInfo.queueCount = queueFamily == graphicsFamily_ && secondGraphicsQueue ? 2 : 1;
+    queueCreateInfo.pQueuePriorities = queueFamily == transferFamily_ && queueFamily != graphicsFamily_
+        ? &queuePriorities[1] : queuePriorities;
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
+  // optional, only used by the pipeline statistics instrumentation
+  deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+  deviceFeatures.occlusionQueryPrecise = supportedFeatures.occlusionQueryPrecise;
+  enabledFeatures = deviceFeatures;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -158,9 +282,17 @@ void LlyDevice::createLogicalDevice() {
   createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+  // optional, only used to report the memory budget
+  std::vector<const char *> extensions = deviceExtensions;
+  memoryBudgetSupported = getMemoryProperties2 != nullptr &&
+                          deviceExtensionSupported(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  if (memoryBudgetSupported) {
+    extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  }
+
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+  createInfo.ppEnabledExtensionNames = extensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -177,6 +309,15 @@ void LlyDevice::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  vkGetDeviceQueue(device_, transferFamily_, secondGraphicsQueue ? 1 : 0, &transferQueue_);
+
+  if (hasDedicatedTransferFamily()) {
+    std::cout << "transfer queue family: " << transferFamily_ << std::endl;
+  } else if (secondGraphicsQueue) {
+    std::cout << "transfer queue: second graphics queue" << std::endl;
+  } else {
+    std::cout << "transfer queue: shared with graphics" << std::endl;
+  }
 }
 
 void LlyDevice::createCommandPool() {
@@ -193,6 +334,17 @@ void LlyDevice::createCommandPool() {
   }
 }
 
+void LlyDevice::createHostAllocators() {
+  for (uint32_t i = 0; i < static_cast<uint32_t>(MemoryTag::Count); i++) {
+    VkAllocationCallbacks &callbacks = hostAllocators[i];
+    callbacks = {};
+    callbacks.pUserData = reinterpret_cast<void *>(static_cast<uintptr_t>(i));
+    callbacks.pfnAllocation = hostAllocate;
+    callbacks.pfnReallocation = hostReallocate;
+    callbacks.pfnFree = hostFree;
+  }
+}
+
 void LlyDevice::createSurface() { window->createWindowSurface(instance, &surface_); }
 
 bool LlyDevice::isDeviceSuitable(VkPhysicalDevice device) {
@@ -200,8 +352,8 @@ bool LlyDevice::isDeviceSuitable(VkPhysicalDevice device) {
 
   bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported) {
+  bool swapChainAdequate = isHeadless();
+  if (extensionsSupported && !isHeadless()) {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
@@ -261,11 +413,15 @@ bool LlyDevice::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> LlyDevice::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  std::vector<const char *> extensions;
+
+  // glfw isn't even initialized without a window
+  if (!isHeadless()) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -332,8 +488,11 @@ QueueFamilyIndices LlyDevice::findQueueFamilies(VkPhysicalDevice device) {
       indices.graphicsFamily = i;
       indices.graphicsFamilyHasValue = true;
     }
-    VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    // headless, the graphics queue stands in for the present queue
+    VkBool32 presentSupport = isHeadless() && indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i);
+    if (!isHeadless()) {
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    }
     if (queueFamily.queueCount > 0 && presentSupport) {
       indices.presentFamily = i;
       indices.presentFamilyHasValue = true;
@@ -345,6 +504,21 @@ QueueFamilyIndices LlyDevice::findQueueFamilies(VkPhysicalDevice device) {
     i++;
   }
 
+  // prefer a pure copy engine over an async compute family
+  uint32_t bestFlags = 0;
+  for (uint32_t family = 0; family < queueFamilyCount; family++) {
+    const VkQueueFlags flags = queueFamilies[family].queueFlags;
+    if (queueFamilies[family].queueCount == 0 || !(flags & VK_QUEUE_TRANSFER_BIT) ||
+        (flags & VK_QUEUE_GRAPHICS_BIT)) {
+      continue;
+    }
+    if (!indices.transferFamilyHasValue || (bestFlags & VK_QUEUE_COMPUTE_BIT && !(flags & VK_QUEUE_COMPUTE_BIT))) {
+      indices.transferFamily = family;
+      indices.transferFamilyHasValue = true;
+      bestFlags = flags;
+    }
+  }
+
   return indices;
 }
 
@@ -408,7 +582,8 @@ void LlyDevice::createBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    VkDeviceMemory &bufferMemory,
+    MemoryTag tag) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -430,6 +605,7 @@ void LlyDevice::createBuffer(
   if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
     throw std::runtime_error("failed to allocate vertex buffer memory!");
   }
+  trackMemory(bufferMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, tag);
 
   vkBindBufferMemory(device_, buffer, bufferMemory, 0);
 }
@@ -509,7 +685,8 @@ void LlyDevice::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) {
+    VkDeviceMemory &imageMemory,
+    MemoryTag tag) {
   if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
     throw std::runtime_error("failed to create image!");
   }
@@ -525,10 +702,61 @@ void LlyDevice::createImageWithInfo(
   if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
     throw std::runtime_error("failed to allocate image memory!");
   }
+  trackMemory(imageMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, tag);
 
   if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
     throw std::runtime_error("failed to bind image memory!");
   }
 }
 
-}  // namespace ember
\ No newline at end of file
+void LlyDevice::trackMemory(
+    VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, MemoryTag tag) {
+  const uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+  MemoryTracker::RecordAllocation(MemoryDomain::Gpu, tag, size);
+
+  std::lock_guard<std::mutex> lock(trackedMemoryMutex);
+  trackedMemory[memory] = TrackedMemory{size, tag, heapIndex};
+  trackedHeapBytes[heapIndex] += size;
+}
+
+void LlyDevice::freeMemory(VkDeviceMemory memory) {
+  if (memory == VK_NULL_HANDLE) return;
+
+  {
+    std::lock_guard<std::mutex> lock(trackedMemoryMutex);
+    auto it = trackedMemory.find(memory);
+    if (it != trackedMemory.end()) {
+      MemoryTracker::RecordFree(MemoryDomain::Gpu, it->second.tag, it->second.size);
+      trackedHeapBytes[it->second.heapIndex] -= it->second.size;
+      trackedMemory.erase(it);
+    }
+  }
+
+  vkFreeMemory(device_, memory, nullptr);
+}
+
+std::vector<HeapBudget> LlyDevice::getHeapBudgets() {
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+  budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  if (memoryBudgetSupported) {
+    // budget and usage change as the process and others allocate, query
+    // them every time
+    VkPhysicalDeviceMemoryProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    properties2.pNext = &budgetProperties;
+    getMemoryProperties2(physicalDevice, &properties2);
+  }
+
+  std::vector<HeapBudget> heaps(memoryProperties.memoryHeapCount);
+  std::lock_guard<std::mutex> lock(trackedMemoryMutex);
+  for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+    heaps[i].size = memoryProperties.memoryHeaps[i].size;
+    heaps[i].budget = budgetProperties.heapBudget[i];
+    heaps[i].usage = budgetProperties.heapUsage[i];
+    heaps[i].tracked = trackedHeapBytes[i];
+    heaps[i].deviceLocal = (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+  }
+  return heaps;
+}
+
+}  // namespace ember
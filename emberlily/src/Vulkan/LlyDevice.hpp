@@ -1,11 +1,14 @@
 #pragma once
 
 #include "LlyWindow.hpp"
+#include "Core/MemoryTracker.hpp"
 
 // std lib headers
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
-#include <memory>
 
 namespace ember {
 
@@ -20,9 +23,23 @@ struct QueueFamilyIndices {
   uint32_t presentFamily;
   bool graphicsFamilyHasValue = false;
   bool presentFamilyHasValue = false;
+  // a family with transfer but without graphics support, the copy engine
+  // on most discrete GPUs. optional, uploads go to the graphics family without
+  uint32_t transferFamily;
+  bool transferFamilyHasValue = false;
   bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
 };
 
+// What the driver reports for one memory heap next to what the engine has
+// allocated from it. budget and usage are zero without VK_EXT_memory_budget.
+struct HeapBudget {
+  VkDeviceSize size;
+  VkDeviceSize budget;
+  VkDeviceSize usage;
+  VkDeviceSize tracked;
+  bool deviceLocal;
+};
+
 class LlyDevice {
  public:
 #ifdef NDEBUG
@@ -31,6 +48,8 @@ class LlyDevice {
   const bool enableValidationLayers = true;
 #endif
 
+  // A null window makes a headless device: no surface, no swapchain
+  // extension, any queue with graphics support will do
   LlyDevice(std::shared_ptr<LlyWindow> window);
   ~LlyDevice();
 
@@ -41,10 +60,21 @@ class LlyDevice {
   LlyDevice& operator=(LlyDevice &&) = delete;
 
   VkCommandPool getCommandPool() { return commandPool; }
+  VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
   VkDevice device() { return device_; }
   VkSurfaceKHR surface() { return surface_; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  // Queue for uploads. On its own family when the GPU has a transfer only
+  // family, otherwise a second graphics family queue if there is one, the
+  // graphics queue itself as a last resort. Only submit from the main thread.
+  VkQueue transferQueue() { return transferQueue_; }
+  uint32_t graphicsQueueFamily() const { return graphicsFamily_; }
+  uint32_t transferQueueFamily() const { return transferFamily_; }
+  // Buffers written on the transfer queue change queue family ownership
+  // before the graphics queue may read them
+  bool hasDedicatedTransferFamily() const { return transferFamily_ != graphicsFamily_; }
+  bool isHeadless() const { return window == nullptr; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -53,12 +83,15 @@ class LlyDevice {
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
   // Buffer Helper Functions
+  // Memory allocated here is charged to tag in the MemoryTracker, release it
+  // with freeMemory so it's uncharged again
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      VkDeviceMemory &bufferMemory,
+      MemoryTag tag = MemoryTag::Untagged);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -69,9 +102,21 @@ class LlyDevice {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      VkDeviceMemory &imageMemory,
+      MemoryTag tag = MemoryTag::Untagged);
+  void freeMemory(VkDeviceMemory memory);
+
+  // Host allocation callbacks charging the driver's allocations for an
+  // object to tag, pass them wherever a create function takes a pAllocator
+  // and use the same ones to destroy the object
+  const VkAllocationCallbacks *hostAllocator(MemoryTag tag) { return &hostAllocators[static_cast<uint32_t>(tag)]; }
+
+  bool hasMemoryBudget() const { return memoryBudgetSupported; }
+  std::vector<HeapBudget> getHeapBudgets();
 
   VkPhysicalDeviceProperties properties;
+  // features the logical device was created with
+  VkPhysicalDeviceFeatures enabledFeatures{};
 
  private:
   void createInstance();
@@ -80,6 +125,7 @@ class LlyDevice {
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  void createHostAllocators();
 
   // helper functions
   bool isDeviceSuitable(VkPhysicalDevice device);
@@ -98,12 +144,35 @@ class LlyDevice {
   VkCommandPool commandPool;
 
   VkDevice device_;
-  VkSurfaceKHR surface_;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkQueue transferQueue_;
+  uint32_t graphicsFamily_;
+  uint32_t transferFamily_;
+
+  struct TrackedMemory {
+    VkDeviceSize size;
+    MemoryTag tag;
+    uint32_t heapIndex;
+  };
+
+  void trackMemory(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, MemoryTag tag);
+
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  std::mutex trackedMemoryMutex;
+  std::unordered_map<VkDeviceMemory, TrackedMemory> trackedMemory;
+  VkDeviceSize trackedHeapBytes[VK_MAX_MEMORY_HEAPS] = {};
+  VkAllocationCallbacks hostAllocators[static_cast<uint32_t>(MemoryTag::Count)];
+
+  // VK_KHR_get_physical_device_properties2 on the instance and
+  // VK_EXT_memory_budget on the device, both optional
+  bool properties2Supported = false;
+  bool memoryBudgetSupported = false;
+  PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-  const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 };
 
 }  // namespace ember
\ No newline at end of file
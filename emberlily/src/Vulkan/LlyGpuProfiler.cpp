@@ -0,0 +1,178 @@
+#include "LlyGpuProfiler.hpp"
+
+#include <stdexcept>
+
+#include "Core/Asserts.hpp"
+#include "Core/Clock.hpp"
+#include "Core/Profiler.hpp"
+
+namespace ember
+{
+
+LlyGpuProfiler::LlyGpuProfiler(std::shared_ptr<LlyDevice> device, uint32_t framesInFlight)
+    : device_(device), slots_(framesInFlight)
+{
+    const uint32_t graphicsFamily = device_->findPhysicalQueueFamilies().graphicsFamily;
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device_->getPhysicalDevice(), &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device_->getPhysicalDevice(), &familyCount, families.data());
+
+    const uint32_t validBits = families[graphicsFamily].timestampValidBits;
+    const float timestampPeriod = device_->properties.limits.timestampPeriod;
+    if (validBits == 0 || timestampPeriod <= 0.0f) {
+        EM_LOG_WARN("Graphics queue doesn't support timestamps, GPU profiling is off");
+        return;
+    }
+
+    timestampMask_ = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    nanosecondsPerTick_ = timestampPeriod;
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = framesInFlight * MAX_SCOPES_PER_FRAME * 2;
+
+    VkResult ok = vkCreateQueryPool(device_->device(), &poolInfo, nullptr, &queryPool_);
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Could not create timestamp query pool!");
+
+    // Value and availability of every query of a slice
+    results_.resize(MAX_SCOPES_PER_FRAME * 2 * 2);
+}
+
+LlyGpuProfiler::~LlyGpuProfiler()
+{
+    if (queryPool_ != VK_NULL_HANDLE)
+        vkDestroyQueryPool(device_->device(), queryPool_, nullptr);
+}
+
+void LlyGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameSlot)
+{
+    if (!isSupported())
+        return;
+
+    EM_CORE_ASSERT(frameSlot < slots_.size(), "Frame slot out of range");
+
+    collect(frameSlot);
+
+    commandBuffer_ = commandBuffer;
+    frameSlot_ = frameSlot;
+    depth_ = 0;
+    slots_[frameSlot].scopes.clear();
+
+    vkCmdResetQueryPool(commandBuffer, queryPool_, firstQuery(frameSlot), MAX_SCOPES_PER_FRAME * 2);
+}
+
+void LlyGpuProfiler::beginScope(const char* name)
+{
+    if (!isSupported())
+        return;
+
+    // Too deep to track, depth_ keeps counting so the end is skipped too
+    if (depth_ >= MAX_DEPTH) {
+        stats_.scopesDropped++;
+        depth_++;
+        return;
+    }
+
+    auto& scopes = slots_[frameSlot_].scopes;
+    if (scopes.size() == MAX_SCOPES_PER_FRAME) {
+        stats_.scopesDropped++;
+        openScopes_[depth_++] = UINT32_MAX;
+        return;
+    }
+
+    const uint32_t index = static_cast<uint32_t>(scopes.size());
+    scopes.push_back(Scope{name, depth_});
+    openScopes_[depth_++] = index;
+
+    vkCmdWriteTimestamp(
+        commandBuffer_, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool_, firstQuery(frameSlot_) + index * 2);
+}
+
+void LlyGpuProfiler::endScope()
+{
+    if (!isSupported())
+        return;
+
+    // Unmatched ends are ignored
+    if (depth_ == 0)
+        return;
+    depth_--;
+    if (depth_ >= MAX_DEPTH)
+        return;
+
+    const uint32_t index = openScopes_[depth_];
+    if (index == UINT32_MAX)
+        return;
+
+    vkCmdWriteTimestamp(
+        commandBuffer_, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool_, firstQuery(frameSlot_) + index * 2 + 1);
+}
+
+void LlyGpuProfiler::endFrame()
+{
+    if (!isSupported())
+        return;
+
+    EM_CORE_ASSERT(depth_ == 0, "GPU scopes still open at the end of the frame");
+
+    FrameSlot& slot = slots_[frameSlot_];
+    slot.submitTicks = Clock::Ticks();
+    slot.pending = !slot.scopes.empty();
+}
+
+void LlyGpuProfiler::collect(uint32_t frameSlot)
+{
+    FrameSlot& slot = slots_[frameSlot];
+    if (!slot.pending)
+        return;
+    slot.pending = false;
+
+    const uint32_t queryCount = static_cast<uint32_t>(slot.scopes.size()) * 2;
+
+    // No wait flag, a frame that isn't done yet is dropped instead of
+    // stalling the CPU
+    VkResult result = vkGetQueryPoolResults(
+        device_->device(),
+        queryPool_,
+        firstQuery(frameSlot),
+        queryCount,
+        queryCount * 2 * sizeof(uint64_t),
+        results_.data(),
+        2 * sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    if (result != VK_SUCCESS) {
+        stats_.framesMissed++;
+        return;
+    }
+
+    const double ticksPerNanosecond = Clock::TicksPerSecond() / 1e9;
+    const uint64_t frameStart = results_[0];
+
+    auto toCpuTicks = [&](uint64_t timestamp) {
+        const uint64_t elapsed = (timestamp - frameStart) & timestampMask_;
+        return slot.submitTicks + static_cast<uint64_t>(elapsed * nanosecondsPerTick_ * ticksPerNanosecond);
+    };
+
+    uint64_t topLevelTicks = 0;
+    for (uint32_t i = 0; i < slot.scopes.size(); i++) {
+        const uint64_t* begin = &results_[i * 4];
+        const uint64_t* end = &results_[i * 4 + 2];
+        if (!begin[1] || !end[1])
+            continue;
+
+        if (slot.scopes[i].depth == 0)
+            topLevelTicks += (end[0] - begin[0]) & timestampMask_;
+
+        Profiler::AddGpuScope(slot.scopes[i].name, toCpuTicks(begin[0]), toCpuTicks(end[0]), slot.scopes[i].depth);
+    }
+
+    lastFrameMilliseconds_ = topLevelTicks * nanosecondsPerTick_ / 1e6;
+    framesCollected_++;
+}
+
+} // namespace ember
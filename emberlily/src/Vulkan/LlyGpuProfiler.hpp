@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "Core/Profiler.hpp"
+#include "LlyDevice.hpp"
+
+namespace ember
+{
+
+// Times command buffer scopes with timestamp queries. Each frame in flight
+// owns a slice of one query pool; a slice is read back when its frame slot
+// comes around again, by then the in-flight fence has been waited on so the
+// results are there without stalling. Finished scopes are handed to the
+// Profiler on the GPU track, converted to CPU ticks.
+//
+// Vulkan 1.0 has no way to correlate both clocks, the first timestamp of a
+// frame is placed at the moment its command buffer was submitted. Durations
+// are exact, the offset from submission to execution is not shown.
+class LlyGpuProfiler
+{
+public:
+    static constexpr uint32_t MAX_SCOPES_PER_FRAME = 32;
+    static constexpr uint32_t MAX_DEPTH = 16;
+
+    struct Stats
+    {
+        // Frames whose results weren't ready when their slot was reused
+        uint32_t framesMissed = 0;
+        // Scopes skipped because a frame ran out of queries or they nested
+        // deeper than MAX_DEPTH
+        uint32_t scopesDropped = 0;
+    };
+
+    LlyGpuProfiler(std::shared_ptr<LlyDevice> device, uint32_t framesInFlight);
+    ~LlyGpuProfiler();
+
+    LlyGpuProfiler(const LlyGpuProfiler&) = delete;
+    LlyGpuProfiler& operator=(const LlyGpuProfiler&) = delete;
+
+    // False when the graphics queue has no timestamp support, every call
+    // below does nothing then
+    bool isSupported() const { return queryPool_ != VK_NULL_HANDLE; }
+
+    // Call right after vkBeginCommandBuffer, outside of a render pass.
+    // Collects what the slot measured last time and resets its queries.
+    void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameSlot);
+    // Scopes can nest and may span render pass boundaries
+    void beginScope(const char* name);
+    void endScope();
+    // Call right before the command buffer is submitted
+    void endFrame();
+
+    const Stats& getStats() const { return stats_; }
+
+    // GPU time of the top level scopes of the last frame read back, and how
+    // many frames have been read back so far
+    double getLastFrameMilliseconds() const { return lastFrameMilliseconds_; }
+    uint64_t getFramesCollected() const { return framesCollected_; }
+
+private:
+    struct Scope
+    {
+        const char* name;
+        uint32_t depth;
+    };
+
+    struct FrameSlot
+    {
+        // Scope i uses queries 2 * i and 2 * i + 1 of the slice
+        std::vector<Scope> scopes;
+        uint64_t submitTicks = 0;
+        bool pending = false;
+    };
+
+    void collect(uint32_t frameSlot);
+    uint32_t firstQuery(uint32_t frameSlot) const { return frameSlot * MAX_SCOPES_PER_FRAME * 2; }
+
+    std::shared_ptr<LlyDevice> device_;
+    VkQueryPool queryPool_ = VK_NULL_HANDLE;
+    double nanosecondsPerTick_ = 1.0;
+    uint64_t timestampMask_ = ~0ull;
+
+    std::vector<FrameSlot> slots_;
+    std::vector<uint64_t> results_;
+    Stats stats_;
+    double lastFrameMilliseconds_ = 0.0;
+    uint64_t framesCollected_ = 0;
+
+    // Frame being recorded
+    VkCommandBuffer commandBuffer_ = VK_NULL_HANDLE;
+    uint32_t frameSlot_ = 0;
+    // Scope index of every open scope, UINT32_MAX for dropped ones
+    uint32_t openScopes_[MAX_DEPTH];
+    // Counts scopes nested past MAX_DEPTH too
+    uint32_t depth_ = 0;
+};
+
+// Times the enclosing block of commands, profiler may be null
+class LlyGpuScope
+{
+public:
+    inline LlyGpuScope(LlyGpuProfiler* profiler, const char* name)
+        : profiler_(profiler)
+    {
+        if (profiler_)
+            profiler_->beginScope(name);
+    }
+    inline ~LlyGpuScope()
+    {
+        if (profiler_)
+            profiler_->endScope();
+    }
+
+    LlyGpuScope(const LlyGpuScope&) = delete;
+    LlyGpuScope& operator=(const LlyGpuScope&) = delete;
+
+private:
+    LlyGpuProfiler* profiler_;
+};
+
+} // namespace ember
+
+#ifdef EM_ENABLE_PROFILER
+    #define EM_PROFILE_GPU_SCOPE(profiler, name) \
+        ::ember::LlyGpuScope EM_PROFILE_CONCAT(emGpuScope_, __LINE__)(profiler, name)
+#else
+    #define EM_PROFILE_GPU_SCOPE(profiler, name)
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ember
+{
+
+// Binary mesh container (.emesh), written by tools/convert_mesh.py. The file
+// is mapped and its blobs are copied straight into the staging buffer, so
+// everything is stored the way the GPU reads it:
+//
+//   MeshFileHeader
+//   vertex blob     vertexCount * vertexStride bytes at vertexOffset
+//   index blob      indexCount * indexSize bytes at indexOffset
+//
+// Both offsets are multiples of MESH_FILE_ALIGNMENT. All fields are little
+// endian. Bump MESH_FILE_VERSION on any layout change, older files are
+// rejected rather than guessed at.
+constexpr char MESH_FILE_MAGIC[4] = {'E', 'M', 'S', 'H'};
+constexpr uint32_t MESH_FILE_VERSION = 2;
+constexpr uint32_t MESH_FILE_ALIGNMENT = 64;
+constexpr uint32_t MESH_FILE_MAX_ATTRIBUTES = 8;
+
+// One vertex input attribute, format is a VkFormat
+struct MeshFileAttribute
+{
+    uint32_t location;
+    uint32_t format;
+    uint32_t offset;
+};
+
+struct MeshFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexCount;
+    // 0 for a non indexed mesh
+    uint32_t indexCount;
+    uint32_t vertexStride;
+    // 2 or 4, 0 without indices
+    uint32_t indexSize;
+    uint32_t attributeCount;
+    uint32_t reserved;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    MeshFileAttribute attributes[MESH_FILE_MAX_ATTRIBUTES];
+    // Maps snorm16 positions back to model space, 1 and 0 for the float
+    // layouts. See PositionDecode.
+    float positionScale[2];
+    float positionOffset[2];
+};
+
+static_assert(sizeof(MeshFileAttribute) == 12, "Mesh file attribute layout changed");
+static_assert(sizeof(MeshFileHeader) == 160, "Mesh file header layout changed");
+static_assert(offsetof(MeshFileHeader, vertexOffset) == 32, "Mesh file header layout changed");
+
+} // namespace ember
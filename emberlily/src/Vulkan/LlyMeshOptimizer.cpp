@@ -0,0 +1,406 @@
+#include "LlyMeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Core/Asserts.hpp"
+#include "Core/Clock.hpp"
+#include "Core/Profiler.hpp"
+
+namespace ember
+{
+
+namespace
+{
+
+// Forsyth's constants. The cache modelled while ordering is bigger than the
+// FIFO analyzed, an LRU that big behaves close to the real thing.
+constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+// Valences scored from the table, higher ones are computed
+constexpr uint32_t MAX_TABLE_VALENCE = 32;
+
+struct ScoreTables
+{
+    float cache[FORSYTH_CACHE_SIZE];
+    float valence[MAX_TABLE_VALENCE];
+
+    ScoreTables()
+    {
+        for (uint32_t i = 0; i < FORSYTH_CACHE_SIZE; i++) {
+            // The last triangle's vertices get a fixed score, so the next
+            // triangle doesn't always continue from the same edge
+            if (i < 3) {
+                cache[i] = LAST_TRIANGLE_SCORE;
+            } else {
+                const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                cache[i] = std::pow(1.0f - (i - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+        valence[0] = 0.0f;
+        for (uint32_t i = 1; i < MAX_TABLE_VALENCE; i++)
+            valence[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+    }
+};
+
+const ScoreTables scoreTables;
+
+inline float vertexScore(int32_t cachePosition, uint32_t activeTriangles)
+{
+    // No triangles left, the vertex is done
+    if (activeTriangles == 0)
+        return -1.0f;
+
+    // Few triangles left are worth finishing off so the vertex can go
+    float score = activeTriangles < MAX_TABLE_VALENCE
+        ? scoreTables.valence[activeTriangles]
+        : VALENCE_BOOST_SCALE * std::pow(static_cast<float>(activeTriangles), -VALENCE_BOOST_POWER);
+    if (cachePosition >= 0)
+        score += scoreTables.cache[cachePosition];
+    return score;
+}
+
+// FIFO with timestamps: a vertex is cached if it was transformed fewer than
+// cacheSize transforms ago. Returns how many of the three missed.
+inline uint32_t updateCache(
+    const uint32_t* triangle,
+    uint32_t cacheSize,
+    std::vector<uint32_t>& timestamps,
+    uint32_t& timestamp)
+{
+    uint32_t misses = 0;
+    for (uint32_t corner = 0; corner < 3; corner++) {
+        const uint32_t vertex = triangle[corner];
+        if (timestamp - timestamps[vertex] > cacheSize) {
+            timestamps[vertex] = timestamp++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+} // namespace
+
+LlyMeshOptimizer::CacheStats LlyMeshOptimizer::analyzeVertexCache(
+    const uint32_t* indices,
+    size_t indexCount,
+    uint32_t vertexCount,
+    uint32_t cacheSize)
+{
+    CacheStats stats;
+    stats.triangles = static_cast<uint32_t>(indexCount / 3);
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t timestamp = cacheSize + 1;
+    std::vector<uint8_t> used(vertexCount, 0);
+
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        stats.transforms += updateCache(&indices[i], cacheSize, timestamps, timestamp);
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            stats.vertices += used[indices[i + corner]] == 0;
+            used[indices[i + corner]] = 1;
+        }
+    }
+    return stats;
+}
+
+void LlyMeshOptimizer::optimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount)
+{
+    EM_PROFILE_FUNCTION();
+    EM_CORE_ASSERT(indexCount % 3 == 0, "Index count must be a multiple of 3");
+
+    const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+    if (triangleCount == 0)
+        return;
+
+    // Triangles around every vertex, the first activeTriangles of each list
+    // are the ones not emitted yet
+    std::vector<uint32_t> activeTriangles(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; i++)
+        activeTriangles[indices[i]]++;
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + activeTriangles[v];
+
+    std::vector<uint32_t> adjacency(indexCount);
+    {
+        std::vector<uint32_t> filled(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < indexCount; i++)
+            adjacency[filled[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<int32_t> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        vertexScores[v] = vertexScore(-1, activeTriangles[v]);
+
+    uint32_t best = 0;
+    float bestScore = -1.0f;
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        const uint32_t* triangle = &indices[t * 3];
+        const float score = vertexScores[triangle[0]] + vertexScores[triangle[1]] + vertexScores[triangle[2]];
+        if (score > bestScore) {
+            bestScore = score;
+            best = t;
+        }
+    }
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> result(indexCount);
+    // Room for the three vertices pushed in front before the end falls off
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t cacheCount = 0;
+    // Where to look for a triangle when nothing around the cache is left
+    uint32_t deadEndCursor = 0;
+
+    for (uint32_t out = 0; out < triangleCount; out++) {
+        if (best == UINT32_MAX) {
+            while (emitted[deadEndCursor])
+                deadEndCursor++;
+            best = deadEndCursor;
+        }
+
+        const uint32_t* triangle = &indices[best * 3];
+        std::memcpy(&result[out * 3], triangle, 3 * sizeof(uint32_t));
+        emitted[best] = 1;
+
+        uint32_t newCount = 0;
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            const uint32_t vertex = triangle[corner];
+
+            // Move the triangle past the end of the vertex's active list
+            uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+            const uint32_t count = activeTriangles[vertex];
+            for (uint32_t i = 0; i < count; i++) {
+                if (list[i] == best) {
+                    std::swap(list[i], list[count - 1]);
+                    break;
+                }
+            }
+            activeTriangles[vertex]--;
+
+            // Degenerate triangles repeat a vertex, it goes in once
+            if (std::find(newCache, newCache + newCount, vertex) == newCache + newCount)
+                newCache[newCount++] = vertex;
+        }
+        for (uint32_t i = 0; i < cacheCount; i++) {
+            const uint32_t vertex = cache[i];
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                newCache[newCount++] = vertex;
+        }
+
+        for (uint32_t i = 0; i < newCount; i++) {
+            const uint32_t vertex = newCache[i];
+            cachePositions[vertex] = i < FORSYTH_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+            vertexScores[vertex] = vertexScore(cachePositions[vertex], activeTriangles[vertex]);
+        }
+
+        // Only the triangles around vertices whose score changed can have
+        // changed, the best of them goes next
+        best = UINT32_MAX;
+        bestScore = -1.0f;
+        for (uint32_t i = 0; i < newCount; i++) {
+            const uint32_t vertex = newCache[i];
+            const uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+            for (uint32_t j = 0; j < activeTriangles[vertex]; j++) {
+                const uint32_t t = list[j];
+                const uint32_t* corners = &indices[t * 3];
+                const float score = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+        std::memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+    }
+
+    std::memcpy(indices, result.data(), indexCount * sizeof(uint32_t));
+}
+
+void LlyMeshOptimizer::optimizeOverdraw(
+    uint32_t* indices,
+    size_t indexCount,
+    const float* positions,
+    uint32_t vertexCount,
+    size_t positionStride,
+    float threshold)
+{
+    EM_PROFILE_FUNCTION();
+    EM_CORE_ASSERT(indexCount % 3 == 0, "Index count must be a multiple of 3");
+
+    const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+    if (triangleCount == 0)
+        return;
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t timestamp = DEFAULT_CACHE_SIZE + 1;
+
+    // Hard boundaries where a triangle misses all three vertices, the cache
+    // order started a new patch of the mesh there
+    std::vector<uint32_t> hardBoundaries;
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        if (updateCache(&indices[t * 3], DEFAULT_CACHE_SIZE, timestamps, timestamp) == 3 || t == 0)
+            hardBoundaries.push_back(t);
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    // Soft boundaries split a patch wherever the ACMR since the last split
+    // has come down to within threshold of the whole patch's
+    std::vector<uint32_t> clusters;
+    for (size_t h = 0; h + 1 < hardBoundaries.size(); h++) {
+        const uint32_t begin = hardBoundaries[h];
+        const uint32_t end = hardBoundaries[h + 1];
+
+        // Flushing the cache is moving the timestamp past every entry
+        timestamp += DEFAULT_CACHE_SIZE + 1;
+        uint32_t patchMisses = 0;
+        for (uint32_t t = begin; t < end; t++)
+            patchMisses += updateCache(&indices[t * 3], DEFAULT_CACHE_SIZE, timestamps, timestamp);
+        const float clusterThreshold = threshold * static_cast<float>(patchMisses) / (end - begin);
+
+        clusters.push_back(begin);
+        timestamp += DEFAULT_CACHE_SIZE + 1;
+        uint32_t misses = 0;
+        uint32_t triangles = 0;
+        for (uint32_t t = begin; t < end; t++) {
+            misses += updateCache(&indices[t * 3], DEFAULT_CACHE_SIZE, timestamps, timestamp);
+            triangles++;
+            if (static_cast<float>(misses) / triangles <= clusterThreshold && t + 1 < end) {
+                clusters.push_back(t + 1);
+                timestamp += DEFAULT_CACHE_SIZE + 1;
+                misses = 0;
+                triangles = 0;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+    const size_t clusterCount = clusters.size() - 1;
+
+    auto position = [&](uint32_t vertex) {
+        return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+    };
+
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < indexCount; i++) {
+        const float* p = position(indices[i]);
+        for (uint32_t axis = 0; axis < 3; axis++)
+            meshCentroid[axis] += p[axis];
+    }
+    for (float& axis : meshCentroid)
+        axis /= static_cast<float>(indexCount);
+
+    // How far a cluster faces away from the middle: its area weighted
+    // centroid relative to the mesh's, along its average normal
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        float area = 0.0f;
+        float centroid[3] = {0.0f, 0.0f, 0.0f};
+        float normal[3] = {0.0f, 0.0f, 0.0f};
+
+        for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++) {
+            const float* p0 = position(indices[t * 3 + 0]);
+            const float* p1 = position(indices[t * 3 + 1]);
+            const float* p2 = position(indices[t * 3 + 2]);
+
+            const float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            const float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            const float n[3] = {
+                e1[1] * e2[2] - e1[2] * e2[1],
+                e1[2] * e2[0] - e1[0] * e2[2],
+                e1[0] * e2[1] - e1[1] * e2[0]};
+            const float triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (uint32_t axis = 0; axis < 3; axis++) {
+                centroid[axis] += (p0[axis] + p1[axis] + p2[axis]) * (triangleArea / 3.0f);
+                normal[axis] += n[axis];
+            }
+            area += triangleArea;
+        }
+
+        const float inverseArea = area > 0.0f ? 1.0f / area : 0.0f;
+        const float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        const float inverseLength = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+
+        float key = 0.0f;
+        for (uint32_t axis = 0; axis < 3; axis++)
+            key += (centroid[axis] * inverseArea - meshCentroid[axis]) * normal[axis] * inverseLength;
+        sortKeys[c] = key;
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indexCount);
+    for (uint32_t c : order)
+        result.insert(result.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+    std::memcpy(indices, result.data(), indexCount * sizeof(uint32_t));
+}
+
+uint32_t LlyMeshOptimizer::optimizeVertexFetch(
+    void* vertices,
+    uint32_t vertexCount,
+    size_t vertexStride,
+    uint32_t* indices,
+    size_t indexCount)
+{
+    EM_PROFILE_FUNCTION();
+
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; i++) {
+        uint32_t& target = remap[indices[i]];
+        if (target == UINT32_MAX)
+            target = next++;
+        indices[i] = target;
+    }
+
+    auto* bytes = static_cast<uint8_t*>(vertices);
+    std::vector<uint8_t> original(bytes, bytes + static_cast<size_t>(vertexCount) * vertexStride);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        if (remap[v] != UINT32_MAX)
+            std::memcpy(bytes + remap[v] * vertexStride, original.data() + v * vertexStride, vertexStride);
+    }
+    return next;
+}
+
+void LlyMeshOptimizer::optimize(std::vector<LlyModel::Vertex>& vertices, std::vector<uint32_t>& indices, Stats* stats)
+{
+    EM_PROFILE_FUNCTION();
+
+    const uint64_t startTicks = Clock::Ticks();
+    Stats result;
+    const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    result.before = analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+
+    optimizeVertexCache(indices.data(), indices.size(), vertexCount);
+    vertices.resize(optimizeVertexFetch(vertices.data(), vertexCount, sizeof(LlyModel::Vertex), indices.data(), indices.size()));
+
+    result.seconds = Clock::TicksToSeconds(Clock::Ticks() - startTicks);
+    result.after = analyzeVertexCache(indices.data(), indices.size(), static_cast<uint32_t>(vertices.size()));
+
+    EM_LOG_INFO(
+        "Optimized {0} triangles in {1:.1f} ms: ACMR {2:.3f} -> {3:.3f}, ATVR {4:.3f} -> {5:.3f}",
+        result.after.triangles,
+        result.seconds * 1000.0,
+        result.before.acmr(),
+        result.after.acmr(),
+        result.before.atvr(),
+        result.after.atvr());
+
+    if (stats)
+        *stats = result;
+}
+
+} // namespace ember
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "LlyModel.hpp"
+
+namespace ember
+{
+
+// Reorders indexed triangle lists so the GPU transforms fewer vertices and
+// fetches vertex data in order. Every pass works on plain index arrays and
+// vertex bytes with a stride, so it doesn't care about the vertex layout.
+//
+// The usual order is optimizeVertexCache, then optimizeOverdraw if the mesh
+// has depth, then optimizeVertexFetch, which renumbers the vertices and has
+// to come last. optimize runs them on LlyModel geometry.
+class LlyMeshOptimizer
+{
+public:
+    // FIFO size analyzeVertexCache simulates, about what current GPUs reuse
+    static constexpr uint32_t DEFAULT_CACHE_SIZE = 16;
+
+    struct CacheStats
+    {
+        uint32_t triangles = 0;
+        // Distinct vertices the indices refer to
+        uint32_t vertices = 0;
+        // Vertex shader runs with the simulated cache
+        uint32_t transforms = 0;
+
+        // Average cache miss ratio, transforms per triangle. 3 is the worst,
+        // a regular grid gets close to 0.5.
+        double acmr() const { return triangles > 0 ? static_cast<double>(transforms) / triangles : 0.0; }
+        // Average transform to vertex ratio, 1 means every vertex ran once
+        double atvr() const { return vertices > 0 ? static_cast<double>(transforms) / vertices : 0.0; }
+    };
+
+    struct Stats
+    {
+        CacheStats before;
+        CacheStats after;
+        double seconds = 0.0;
+    };
+
+    // Simulates a FIFO post-transform cache over indices in draw order
+    static CacheStats analyzeVertexCache(
+        const uint32_t* indices,
+        size_t indexCount,
+        uint32_t vertexCount,
+        uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+    // Tom Forsyth's linear-speed vertex cache optimisation: repeatedly emits
+    // the triangle whose vertices score best, a vertex scoring higher the
+    // more recently it was used and the fewer triangles it has left. Only
+    // the triangles around the simulated cache are rescored each step.
+    static void optimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount);
+
+    // Sander, Nehab and Barczak's fast triangle reordering: splits the cache
+    // optimized order into clusters that keep most of its cache efficiency
+    // (ACMR within threshold of the original) and draws the clusters facing
+    // outwards from the middle of the mesh first, so depth testing rejects
+    // more of what comes after. positions points at three floats per vertex.
+    static void optimizeOverdraw(
+        uint32_t* indices,
+        size_t indexCount,
+        const float* positions,
+        uint32_t vertexCount,
+        size_t positionStride,
+        float threshold = 1.05f);
+
+    // Renumbers the vertices in the order the indices first use them and
+    // moves the vertex data to match, so vertex fetch walks memory forward.
+    // Vertices no index refers to are dropped, returns how many are left.
+    static uint32_t optimizeVertexFetch(
+        void* vertices,
+        uint32_t vertexCount,
+        size_t vertexStride,
+        uint32_t* indices,
+        size_t indexCount);
+
+    // Vertex cache then vertex fetch order on imported geometry, logs ACMR
+    // and ATVR before and after. Vertex is 2D, all of a model's triangles
+    // sit at the same depth, so the overdraw pass has nothing to win there.
+    static void optimize(std::vector<LlyModel::Vertex>& vertices, std::vector<uint32_t>& indices, Stats* stats = nullptr);
+};
+
+} // namespace ember
@@ -1,66 +1,382 @@
 #include "LlyModel.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
 #include "Core/Asserts.hpp"
+#include "Core/MappedFile.hpp"
+#include "LlyMeshFormat.hpp"
+#include "LlyMeshOptimizer.hpp"
+#include "LlyObjLoader.hpp"
 
 namespace ember
 {
 
 std::vector<VkVertexInputBindingDescription> LlyModel::Vertex::getBindingDescriptions()
 {
-    std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
-    bindingDescriptions[0].binding = 0;
-    bindingDescriptions[0].stride = sizeof(Vertex);
-    bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-    return bindingDescriptions;
+    return getVertexBindingDescriptions(VertexFormat::Float);
 }
 
 std::vector<VkVertexInputAttributeDescription> LlyModel::Vertex::getAttributeDescriptions()
 {
-    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
-    attributeDescriptions[0].binding = 0;
-    attributeDescriptions[0].location = 0;
-    attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-    attributeDescriptions[0].offset = offsetof(Vertex, position);  
+    return getVertexAttributeDescriptions(VertexFormat::Float);
+}
 
-    attributeDescriptions[1].binding = 0;
-    attributeDescriptions[1].location = 1;
-    attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;  
-    attributeDescriptions[1].offset = offsetof(Vertex, color);
+LlyModel::LlyModel(std::shared_ptr<LlyDevice> device, const std::vector<Vertex>& vertices)
+    : LlyModel(device, MeshData{vertices.data(), static_cast<uint32_t>(vertices.size()), sizeof(Vertex)})
+{
+}
 
-    return attributeDescriptions;
+LlyModel::LlyModel(
+    std::shared_ptr<LlyDevice> device,
+    const std::vector<Vertex>& vertices,
+    const std::vector<uint32_t>& indices)
+    : LlyModel(device, MeshData{
+          vertices.data(), static_cast<uint32_t>(vertices.size()), sizeof(Vertex),
+          indices.data(), static_cast<uint32_t>(indices.size()), VK_INDEX_TYPE_UINT32})
+{
 }
 
-LlyModel::LlyModel(std::shared_ptr<LlyDevice> device, const std::vector<Vertex>& vertices)
+LlyModel::LlyModel(
+    std::shared_ptr<LlyDevice> device,
+    const std::vector<Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    VertexFormat format)
     : device_(device)
 {
-    createVertexBuffers(vertices);
+    static_assert(sizeof(Vertex) == 20, "Vertex has to stay VertexFormat::Float");
+
+    std::vector<uint8_t> bytes;
+    MeshData mesh{};
+    encodeVertices(vertices, format, bytes, mesh.positionDecode);
+    mesh.vertices = bytes.data();
+    mesh.vertexCount = static_cast<uint32_t>(vertices.size());
+    mesh.vertexStride = getVertexStride(format);
+    mesh.indices = indices.empty() ? nullptr : indices.data();
+    mesh.indexCount = static_cast<uint32_t>(indices.size());
+    mesh.indexType = VK_INDEX_TYPE_UINT32;
+    mesh.format = format;
+
+    id_ = nextId();
+    setFormat(mesh);
+    createBuffers(mesh);
+}
+
+LlyModel::LlyModel(std::shared_ptr<LlyDevice> device, const MeshData& mesh)
+    : LlyModel(device, mesh, true)
+{
+}
+
+LlyModel::LlyModel(std::shared_ptr<LlyDevice> device, const MeshData& mesh, bool upload)
+    : device_(device)
+{
+    id_ = nextId();
+    setFormat(mesh);
+
+    if (upload)
+        createBuffers(mesh);
+    else
+        createDeviceBuffers(mesh);
 }
 
 LlyModel::~LlyModel()
 {
     vkDestroyBuffer(device_->device(), vertexBuffer_, nullptr);
-    vkFreeMemory(device_->device(), vertexBufferMemory_, nullptr);
+    device_->freeMemory(vertexBufferMemory_);
+
+    if (indexBuffer_ != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device_->device(), indexBuffer_, nullptr);
+        device_->freeMemory(indexBufferMemory_);
+    }
+}
+
+uint32_t LlyModel::nextId()
+{
+    // Streamed models are created on I/O threads
+    static std::atomic<uint32_t> currentId{0};
+    return currentId.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LlyModel::setFormat(const MeshData& mesh)
+{
+    EM_CORE_ASSERT(mesh.format < VertexFormat::Count, "Unknown vertex format");
+    EM_CORE_ASSERT(mesh.vertexStride == getVertexStride(mesh.format), "Vertex stride doesn't match the format");
+    format_ = mesh.format;
+    positionDecode_ = format_ == VertexFormat::Snorm16 ? mesh.positionDecode : IDENTITY_POSITION_DECODE;
+}
+
+static bool isVertexLayout(const MeshFileHeader& header, VertexFormat format)
+{
+    const auto attributes = getVertexAttributeDescriptions(format);
+    if (header.vertexStride != getVertexStride(format) || header.attributeCount != attributes.size())
+        return false;
+
+    for (uint32_t i = 0; i < header.attributeCount; i++) {
+        const MeshFileAttribute& attribute = header.attributes[i];
+        if (attribute.location != attributes[i].location || attribute.format != attributes[i].format ||
+            attribute.offset != attributes[i].offset)
+            return false;
+    }
+    return true;
+}
+
+// Largest index a mesh file refers to, the blob is aligned for its type
+template <typename Index>
+static uint32_t findMaxIndex(const uint8_t* indices, uint32_t indexCount)
+{
+    const auto* typed = reinterpret_cast<const Index*>(indices);
+    uint32_t maxIndex = 0;
+    for (uint32_t i = 0; i < indexCount; i++)
+        maxIndex = typed[i] > maxIndex ? typed[i] : maxIndex;
+    return maxIndex;
+}
+
+static bool findVertexFormat(const MeshFileHeader& header, VertexFormat& format)
+{
+    for (uint32_t i = 0; i < static_cast<uint32_t>(VertexFormat::Count); i++) {
+        if (isVertexLayout(header, static_cast<VertexFormat>(i))) {
+            format = static_cast<VertexFormat>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LlyModel::readMeshFile(const void* data, size_t size, const char* path, MeshData& mesh)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+
+    MeshFileHeader header;
+    if (size < sizeof(header)) {
+        EM_LOG_ERROR("{0} is too small to be a mesh file", path);
+        return false;
+    }
+    std::memcpy(&header, bytes, sizeof(header));
+
+    if (std::memcmp(header.magic, MESH_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        EM_LOG_ERROR("{0} is not a mesh file", path);
+        return false;
+    }
+    if (header.version != MESH_FILE_VERSION) {
+        EM_LOG_ERROR("{0} is mesh file version {1}, expected {2}, convert it again", path, header.version, MESH_FILE_VERSION);
+        return false;
+    }
+    VertexFormat format;
+    if (header.attributeCount > MESH_FILE_MAX_ATTRIBUTES || !findVertexFormat(header, format)) {
+        EM_LOG_ERROR("{0} has a vertex layout the model pipeline can't read", path);
+        return false;
+    }
+
+    const uint64_t vertexBytes = static_cast<uint64_t>(header.vertexCount) * header.vertexStride;
+    const uint64_t indexBytes = static_cast<uint64_t>(header.indexCount) * header.indexSize;
+    const bool indexSizeValid = header.indexCount == 0 || header.indexSize == 2 || header.indexSize == 4;
+    if (!indexSizeValid || header.vertexOffset % MESH_FILE_ALIGNMENT != 0 || header.indexOffset % MESH_FILE_ALIGNMENT != 0 ||
+        header.vertexOffset > size || vertexBytes > size - header.vertexOffset ||
+        header.indexOffset > size || indexBytes > size - header.indexOffset) {
+        EM_LOG_ERROR("{0} is truncated or corrupt", path);
+        return false;
+    }
+
+    // Models are drawn as triangle lists without robust buffer access, an
+    // index past the vertex blob would read outside the buffer on the GPU
+    const uint32_t drawCount = header.indexCount > 0 ? header.indexCount : header.vertexCount;
+    bool geometryValid = header.vertexCount >= 3 && drawCount % 3 == 0;
+    if (geometryValid && header.indexCount > 0) {
+        const uint8_t* indices = bytes + header.indexOffset;
+        const uint32_t maxIndex = header.indexSize == 2 ? findMaxIndex<uint16_t>(indices, header.indexCount)
+                                                        : findMaxIndex<uint32_t>(indices, header.indexCount);
+        geometryValid = maxIndex < header.vertexCount;
+    }
+    if (!geometryValid) {
+        EM_LOG_ERROR("{0} is truncated or corrupt", path);
+        return false;
+    }
+
+    mesh = MeshData{};
+    mesh.vertices = bytes + header.vertexOffset;
+    mesh.vertexCount = header.vertexCount;
+    mesh.vertexStride = header.vertexStride;
+    mesh.format = format;
+    std::memcpy(mesh.positionDecode.scale, header.positionScale, sizeof(mesh.positionDecode.scale));
+    std::memcpy(mesh.positionDecode.offset, header.positionOffset, sizeof(mesh.positionDecode.offset));
+    if (header.indexCount > 0) {
+        mesh.indices = bytes + header.indexOffset;
+        mesh.indexCount = header.indexCount;
+        mesh.indexType = header.indexSize == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    }
+    return true;
+}
+
+VkDeviceSize LlyModel::vertexBytes(const MeshData& mesh)
+{
+    return static_cast<VkDeviceSize>(mesh.vertexStride) * mesh.vertexCount;
+}
+
+VkDeviceSize LlyModel::indexBytes(const MeshData& mesh)
+{
+    return static_cast<VkDeviceSize>(mesh.indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4) * mesh.indexCount;
+}
+
+std::unique_ptr<LlyModel> LlyModel::createFromFile(std::shared_ptr<LlyDevice> device, const char* path)
+{
+    MappedFile file;
+    if (!file.Open(path)) {
+        EM_LOG_ERROR("Could not open mesh file {0}", path);
+        return nullptr;
+    }
+
+    MeshData mesh;
+    if (!readMeshFile(file.GetData(), file.GetSize(), path, mesh))
+        return nullptr;
+
+    // The upload is done once the constructor returns, the mapping can go
+    return std::make_unique<LlyModel>(device, mesh);
 }
 
-void LlyModel::createVertexBuffers(const std::vector<Vertex>& vertices)
+std::unique_ptr<LlyModel> LlyModel::createFromObj(std::shared_ptr<LlyDevice> device, const char* path, VertexFormat format)
 {
-    vertexCount_ = static_cast<uint32_t>(vertices.size());
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    if (!LlyObjLoader::load(path, vertices, indices))
+        return nullptr;
+    // OBJ files come in whatever order the exporter wrote them
+    LlyMeshOptimizer::optimize(vertices, indices);
+
+    return std::make_unique<LlyModel>(device, vertices, indices, format);
+}
+
+void LlyModel::encodeVertices(
+    const std::vector<Vertex>& vertices,
+    VertexFormat format,
+    std::vector<uint8_t>& bytes,
+    PositionDecode& decode)
+{
+    decode = IDENTITY_POSITION_DECODE;
+    const uint32_t stride = getVertexStride(format);
+    bytes.resize(vertices.size() * stride);
+
+    if (format == VertexFormat::Float) {
+        std::memcpy(bytes.data(), vertices.data(), bytes.size());
+        return;
+    }
+
+    if (format == VertexFormat::Snorm16 && !vertices.empty()) {
+        glm::vec2 low = vertices[0].position;
+        glm::vec2 high = vertices[0].position;
+        for (const Vertex& vertex : vertices) {
+            low = glm::min(low, vertex.position);
+            high = glm::max(high, vertex.position);
+        }
+        // Flat along an axis, any scale decodes it
+        const glm::vec2 halfExtent = (high - low) * 0.5f;
+        decode.scale[0] = halfExtent.x > 0.0f ? halfExtent.x : 1.0f;
+        decode.scale[1] = halfExtent.y > 0.0f ? halfExtent.y : 1.0f;
+        decode.offset[0] = (low.x + high.x) * 0.5f;
+        decode.offset[1] = (low.y + high.y) * 0.5f;
+    }
+
+    auto toSnorm = [](float value) {
+        return static_cast<int16_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+    };
+    auto toUnorm8 = [](float value) {
+        return static_cast<uint8_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+    };
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const Vertex& vertex = vertices[i];
+        uint8_t* out = bytes.data() + i * stride;
+
+        uint16_t position[2];
+        for (int axis = 0; axis < 2; axis++) {
+            position[axis] = format == VertexFormat::Half
+                ? floatToHalf(vertex.position[axis])
+                : static_cast<uint16_t>(toSnorm((vertex.position[axis] - decode.offset[axis]) / decode.scale[axis]));
+        }
+        const uint8_t color[4] = {toUnorm8(vertex.color.x), toUnorm8(vertex.color.y), toUnorm8(vertex.color.z), 255};
+
+        std::memcpy(out, position, sizeof(position));
+        std::memcpy(out + 4, color, sizeof(color));
+    }
+}
+
+std::unique_ptr<LlyModel> LlyModel::createForUpload(std::shared_ptr<LlyDevice> device, const MeshData& mesh)
+{
+    return std::unique_ptr<LlyModel>(new LlyModel(device, mesh, false));
+}
+
+void LlyModel::createDeviceBuffers(const MeshData& mesh)
+{
+    vertexCount_ = mesh.vertexCount;
+    indexCount_ = mesh.indexCount;
+    indexType_ = mesh.indexType;
     EM_CORE_ASSERT(vertexCount_ >= 3, "Vertex count must be at least 3");
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount_;
 
     device_->createBuffer(
-        bufferSize,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        vertexBytes(mesh),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         vertexBuffer_,
-        vertexBufferMemory_
+        vertexBufferMemory_,
+        MemoryTag::Models
+    );
+    if (indexCount_ > 0) {
+        device_->createBuffer(
+            indexBytes(mesh),
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            indexBuffer_,
+            indexBufferMemory_,
+            MemoryTag::Models
+        );
+    }
+}
+
+void LlyModel::createBuffers(const MeshData& mesh)
+{
+    MeshData layout = mesh;
+    layout.indexCount = mesh.indices ? mesh.indexCount : 0;
+
+    const VkDeviceSize vertexBytes = LlyModel::vertexBytes(layout);
+    const VkDeviceSize indexBytes = LlyModel::indexBytes(layout);
+    // Indices go after the vertices in the staging buffer, copy offsets must
+    // be multiples of 4
+    const VkDeviceSize indexOffset = (vertexBytes + 3) & ~static_cast<VkDeviceSize>(3);
+
+    // One staging buffer filled straight from the source, then copied into
+    // device local buffers the GPU reads at full speed
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingMemory;
+    device_->createBuffer(
+        indexOffset + indexBytes,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer,
+        stagingMemory,
+        MemoryTag::Models
     );
 
     void* data;
-    vkMapMemory(device_->device(), vertexBufferMemory_, 0, bufferSize, 0, &data);
-    memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-    vkUnmapMemory(device_->device(), vertexBufferMemory_);
+    vkMapMemory(device_->device(), stagingMemory, 0, indexOffset + indexBytes, 0, &data);
+    memcpy(data, mesh.vertices, static_cast<size_t>(vertexBytes));
+    if (layout.indexCount > 0)
+        memcpy(static_cast<char*>(data) + indexOffset, mesh.indices, static_cast<size_t>(indexBytes));
+    vkUnmapMemory(device_->device(), stagingMemory);
+
+    createDeviceBuffers(layout);
+
+    VkCommandBuffer commandBuffer = device_->beginSingleTimeCommands();
+    VkBufferCopy vertexCopy{0, 0, vertexBytes};
+    vkCmdCopyBuffer(commandBuffer, stagingBuffer, vertexBuffer_, 1, &vertexCopy);
+    if (indexCount_ > 0) {
+        VkBufferCopy indexCopy{indexOffset, 0, indexBytes};
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, indexBuffer_, 1, &indexCopy);
+    }
+    device_->endSingleTimeCommands(commandBuffer);
+
+    vkDestroyBuffer(device_->device(), stagingBuffer, nullptr);
+    device_->freeMemory(stagingMemory);
 }
 
 void LlyModel::bind(VkCommandBuffer commandBuffer)
@@ -68,11 +384,33 @@ void LlyModel::bind(VkCommandBuffer commandBuffer)
     VkBuffer buffers[] = {vertexBuffer_};
     VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+    if (indexCount_ > 0)
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer_, 0, indexType_);
 }
 
 void LlyModel::draw(VkCommandBuffer commandBuffer)
 {
-    vkCmdDraw(commandBuffer, vertexCount_, 1, 0, 0);
+    if (indexCount_ > 0)
+        vkCmdDrawIndexed(commandBuffer, indexCount_, 1, 0, 0, 0);
+    else
+        vkCmdDraw(commandBuffer, vertexCount_, 1, 0, 0);
+}
+
+void LlyModel::bind(LlyCommandRecorder& recorder)
+{
+    VkBuffer buffers[] = {vertexBuffer_};
+    VkDeviceSize offsets[] = {0};
+    recorder.bindVertexBuffers(0, 1, buffers, offsets);
+    if (indexCount_ > 0)
+        recorder.bindIndexBuffer(indexBuffer_, 0, indexType_);
+}
+
+void LlyModel::draw(LlyCommandRecorder& recorder)
+{
+    if (indexCount_ > 0)
+        recorder.drawIndexed(indexCount_, 1, 0, 0, 0);
+    else
+        recorder.draw(vertexCount_, 1, 0, 0);
 }
 
 } // namespace ember
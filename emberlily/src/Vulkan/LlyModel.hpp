@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -7,7 +8,9 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include "LlyCommandRecorder.hpp"
 #include "LlyDevice.hpp"
+#include "LlyVertexFormat.hpp"
 
 namespace ember
 {
@@ -15,6 +18,7 @@ namespace ember
 class LlyModel
 {
 public:
+    // VertexFormat::Float, the layout models are built from
     struct Vertex {
         glm::vec2 position;
         glm::vec3 color;
@@ -23,22 +27,104 @@ public:
         static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
     };
 
+    // Vertex and index bytes already laid out for the GPU, e.g. pointing into
+    // a mapped mesh file. Only read while the model is being created.
+    struct MeshData {
+        const void* vertices;
+        uint32_t vertexCount;
+        uint32_t vertexStride;
+        // Null for a non indexed mesh
+        const void* indices;
+        uint32_t indexCount;
+        VkIndexType indexType;
+        // Layout of the vertex bytes, vertexStride has to match it
+        VertexFormat format;
+        // Only read for VertexFormat::Snorm16
+        PositionDecode positionDecode;
+    };
+
     LlyModel(std::shared_ptr<LlyDevice> device, const std::vector<Vertex>& vertices);
+    LlyModel(std::shared_ptr<LlyDevice> device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+    // Stores the vertices in format, see encodeVertices
+    LlyModel(
+        std::shared_ptr<LlyDevice> device,
+        const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        VertexFormat format);
+    LlyModel(std::shared_ptr<LlyDevice> device, const MeshData& mesh);
     ~LlyModel();
 
+    // Maps a .emesh file (see LlyMeshFormat.hpp) and uploads its blobs
+    // straight from the mapping. Returns null if the file can't be read, is
+    // malformed or its vertex layout isn't one of the VertexFormats.
+    static std::unique_ptr<LlyModel> createFromFile(std::shared_ptr<LlyDevice> device, const char* path);
+    // Imports a Wavefront OBJ file with LlyObjLoader and reorders it for the
+    // vertex cache with LlyMeshOptimizer. Returns null if it can't be
+    // imported.
+    static std::unique_ptr<LlyModel> createFromObj(
+        std::shared_ptr<LlyDevice> device,
+        const char* path,
+        VertexFormat format = VertexFormat::Float);
+    // Empty device local buffers sized for mesh, its data pointers aren't
+    // read. For a caller copying the data in on its own, e.g. LlyAssetStreamer
+    // on the transfer queue. Can be called from any thread.
+    static std::unique_ptr<LlyModel> createForUpload(std::shared_ptr<LlyDevice> device, const MeshData& mesh);
+
+    // Checks a mapped .emesh file and points mesh into it. Logs why and
+    // returns false if it's malformed or its vertex layout isn't one of the
+    // VertexFormats.
+    static bool readMeshFile(const void* data, size_t size, const char* path, MeshData& mesh);
+    // Bytes of the vertex and index data of mesh
+    static VkDeviceSize vertexBytes(const MeshData& mesh);
+    static VkDeviceSize indexBytes(const MeshData& mesh);
+    // Converts vertices to format. Snorm16 positions are stored relative to
+    // the bounds of vertices, decode gets what maps them back.
+    static void encodeVertices(
+        const std::vector<Vertex>& vertices,
+        VertexFormat format,
+        std::vector<uint8_t>& bytes,
+        PositionDecode& decode);
+
     // Delete copy contructors
     LlyModel(const LlyModel&) = delete;
     LlyModel& operator=(const LlyModel&) = delete;
 
     void bind(VkCommandBuffer commandBuffer);
     void draw(VkCommandBuffer commandBuffer);
+    void bind(LlyCommandRecorder& recorder);
+    void draw(LlyCommandRecorder& recorder);
+
+    // Small per-model id, used to group draws by model when sorting
+    uint32_t getId() const { return id_; }
+    // Draw with a pipeline built for this format, and fold the decode into
+    // the model transform
+    VertexFormat getVertexFormat() const { return format_; }
+    const PositionDecode& getPositionDecode() const { return positionDecode_; }
+    VkBuffer getVertexBuffer() const { return vertexBuffer_; }
+    // VK_NULL_HANDLE for a non indexed mesh
+    VkBuffer getIndexBuffer() const { return indexBuffer_; }
 private:
-    void createVertexBuffers(const std::vector<Vertex>& vertices);
+    LlyModel(std::shared_ptr<LlyDevice> device, const MeshData& mesh, bool upload);
+
+    static uint32_t nextId();
+    void setFormat(const MeshData& mesh);
+
+    void createDeviceBuffers(const MeshData& mesh);
+    void createBuffers(const MeshData& mesh);
+
+    uint32_t id_;
+    VertexFormat format_;
+    PositionDecode positionDecode_;
 
     std::shared_ptr<LlyDevice> device_;
     VkBuffer vertexBuffer_;
     VkDeviceMemory vertexBufferMemory_;
     uint32_t vertexCount_;
+
+    VkBuffer indexBuffer_ = VK_NULL_HANDLE;
+    VkDeviceMemory indexBufferMemory_ = VK_NULL_HANDLE;
+    uint32_t indexCount_ = 0;
+    VkIndexType indexType_ = VK_INDEX_TYPE_UINT32;
 };
     
 } // namespace ember
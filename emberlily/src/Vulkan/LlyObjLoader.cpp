@@ -0,0 +1,283 @@
+#include "LlyObjLoader.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#include "Core/Asserts.hpp"
+#include "Core/Clock.hpp"
+#include "Core/JobSystem.hpp"
+#include "Core/MappedFile.hpp"
+#include "Core/Profiler.hpp"
+
+namespace ember
+{
+
+namespace
+{
+
+// A face corner before the vertex positions of all chunks are known.
+// Relative corners came from negative OBJ indices and count from the
+// chunk's own positions, they may point into an earlier chunk.
+struct Corner
+{
+    int32_t position;
+    bool relative;
+};
+
+struct Chunk
+{
+    const char* begin;
+    const char* end;
+    std::vector<LlyModel::Vertex> positions;
+    // Three per triangle
+    std::vector<Corner> corners;
+    uint32_t positionBase = 0;
+    uint32_t cornerBase = 0;
+    // Set when the chunk can't be parsed, with where in the file
+    const char* error = nullptr;
+    const char* errorAt = nullptr;
+};
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipSpaces(const char* p, const char* end)
+{
+    while (p < end && isSpace(*p))
+        p++;
+    return p;
+}
+
+template<typename T>
+inline bool parseNumber(const char*& p, const char* end, T& value)
+{
+    p = skipSpaces(p, end);
+    if (p < end && *p == '+')
+        p++;
+    const auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc())
+        return false;
+    p = result.ptr;
+    return true;
+}
+
+void parseChunk(Chunk& chunk)
+{
+    const char* end = chunk.end;
+    // Corners of the face being read, reused across lines
+    std::vector<Corner> face;
+
+    for (const char* line = chunk.begin; line < end;) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        lineEnd = lineEnd ? lineEnd : end;
+        const char* p = skipSpaces(line, lineEnd);
+
+        if (lineEnd - p >= 2 && p[0] == 'v' && isSpace(p[1])) {
+            float values[6] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+            p += 2;
+            uint32_t count = 0;
+            while (count < 6 && parseNumber(p, lineEnd, values[count]))
+                count++;
+            if (count < 2) {
+                chunk.error = "vertex without x and y";
+                chunk.errorAt = line;
+                return;
+            }
+            // Only a full rgb triple is a color, a lone w is ignored
+            if (count < 6)
+                values[3] = values[4] = values[5] = 1.0f;
+            chunk.positions.push_back({{values[0], values[1]}, {values[3], values[4], values[5]}});
+        } else if (lineEnd - p >= 2 && p[0] == 'f' && isSpace(p[1])) {
+            p += 2;
+            face.clear();
+            int32_t index;
+            while (parseNumber(p, lineEnd, index)) {
+                if (index == 0) {
+                    chunk.error = "face index 0";
+                    chunk.errorAt = line;
+                    return;
+                }
+                face.push_back(index > 0 ? Corner{index - 1, false}
+                                         : Corner{static_cast<int32_t>(chunk.positions.size()) + index, true});
+                // Skip the texture coordinate and normal indices
+                while (p < lineEnd && !isSpace(*p))
+                    p++;
+            }
+
+            for (size_t i = 1; i + 1 < face.size(); i++) {
+                chunk.corners.push_back(face[0]);
+                chunk.corners.push_back(face[i]);
+                chunk.corners.push_back(face[i + 1]);
+            }
+        }
+
+        line = lineEnd + 1;
+    }
+}
+
+inline uint32_t hashVertex(const LlyModel::Vertex& vertex)
+{
+    // FNV-1a over the bytes, identical vertices are bitwise identical
+    uint32_t bits[sizeof(LlyModel::Vertex) / 4];
+    std::memcpy(bits, &vertex, sizeof(bits));
+    uint32_t hash = 2166136261u;
+    for (uint32_t word : bits)
+        hash = (hash ^ word) * 16777619u;
+    return hash ^ (hash >> 15);
+}
+
+} // namespace
+
+bool LlyObjLoader::load(
+    const char* path,
+    std::vector<LlyModel::Vertex>& vertices,
+    std::vector<uint32_t>& indices,
+    Stats* stats)
+{
+    EM_PROFILE_FUNCTION();
+    static_assert(sizeof(LlyModel::Vertex) % 4 == 0, "Vertex hashing reads whole words");
+
+    const uint64_t startTicks = Clock::Ticks();
+    Stats result;
+
+    MappedFile file;
+    if (!file.Open(path)) {
+        EM_LOG_ERROR("Could not open {0}", path);
+        return false;
+    }
+
+    const char* data = static_cast<const char*>(file.GetData());
+    const char* dataEnd = data + file.GetSize();
+    result.bytes = file.GetSize();
+    result.threads = JobSystem::GetWorkerCount();
+
+    // A few chunks per worker so one slow chunk doesn't hold up the others,
+    // each one ending right after a newline
+    const uint64_t chunkSize = std::max<uint64_t>(MIN_CHUNK_SIZE, result.bytes / (result.threads * 4) + 1);
+    std::vector<Chunk> chunks;
+    for (const char* begin = data; begin < dataEnd;) {
+        const char* end = begin + std::min<uint64_t>(chunkSize, dataEnd - begin);
+        if (end < dataEnd) {
+            const char* newline = static_cast<const char*>(std::memchr(end, '\n', dataEnd - end));
+            end = newline ? newline + 1 : dataEnd;
+        }
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = end;
+        chunks.push_back(std::move(chunk));
+        begin = end;
+    }
+    result.chunks = static_cast<uint32_t>(chunks.size());
+
+    JobSystem::ParallelFor(result.chunks, 1, [&chunks](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++)
+            parseChunk(chunks[i]);
+    });
+
+    uint64_t positionCount = 0;
+    uint64_t cornerCount = 0;
+    for (Chunk& chunk : chunks) {
+        if (chunk.error) {
+            EM_LOG_ERROR("{0}: {1} at byte {2}", path, chunk.error, chunk.errorAt - data);
+            return false;
+        }
+        chunk.positionBase = static_cast<uint32_t>(positionCount);
+        chunk.cornerBase = static_cast<uint32_t>(cornerCount);
+        positionCount += chunk.positions.size();
+        cornerCount += chunk.corners.size();
+    }
+    if (positionCount > INT32_MAX || cornerCount > UINT32_MAX) {
+        EM_LOG_ERROR("{0} is too big to import", path);
+        return false;
+    }
+    // Points and lines are skipped, a model needs at least one face
+    if (cornerCount == 0) {
+        EM_LOG_ERROR("{0} has no triangles", path);
+        return false;
+    }
+    result.positions = static_cast<uint32_t>(positionCount);
+    result.triangles = static_cast<uint32_t>(cornerCount / 3);
+
+    const uint64_t parsedTicks = Clock::Ticks();
+
+    // Merge identical vertices through an open addressing table at most half
+    // full, remap takes every position to its merged vertex
+    std::vector<uint32_t> remap(positionCount);
+    size_t tableSize = 16;
+    while (tableSize < positionCount * 2)
+        tableSize <<= 1;
+    std::vector<uint32_t> table(tableSize, UINT32_MAX);
+
+    vertices.clear();
+    vertices.reserve(positionCount);
+    for (const Chunk& chunk : chunks) {
+        for (size_t i = 0; i < chunk.positions.size(); i++) {
+            const LlyModel::Vertex& position = chunk.positions[i];
+            size_t slot = hashVertex(position) & (tableSize - 1);
+            while (table[slot] != UINT32_MAX &&
+                   std::memcmp(&vertices[table[slot]], &position, sizeof(LlyModel::Vertex)) != 0)
+                slot = (slot + 1) & (tableSize - 1);
+
+            if (table[slot] == UINT32_MAX) {
+                table[slot] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(position);
+            }
+            remap[chunk.positionBase + i] = table[slot];
+        }
+    }
+    result.vertices = static_cast<uint32_t>(vertices.size());
+
+    const uint64_t dedupedTicks = Clock::Ticks();
+
+    indices.resize(cornerCount);
+    JobSystem::ParallelFor(result.chunks, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t c = begin; c < end; c++) {
+            Chunk& chunk = chunks[c];
+            for (size_t i = 0; i < chunk.corners.size(); i++) {
+                const Corner corner = chunk.corners[i];
+                const int64_t position = corner.relative
+                    ? static_cast<int64_t>(chunk.positionBase) + corner.position
+                    : corner.position;
+                if (position < 0 || position >= static_cast<int64_t>(positionCount)) {
+                    chunk.error = "face refers to a missing vertex";
+                    chunk.errorAt = chunk.begin;
+                    break;
+                }
+                indices[chunk.cornerBase + i] = remap[position];
+            }
+        }
+    });
+
+    for (const Chunk& chunk : chunks) {
+        if (chunk.error) {
+            EM_LOG_ERROR("{0}: {1} in the chunk starting at byte {2}", path, chunk.error, chunk.errorAt - data);
+            return false;
+        }
+    }
+
+    const uint64_t endTicks = Clock::Ticks();
+    result.parseSeconds = Clock::TicksToSeconds(parsedTicks - startTicks);
+    result.dedupSeconds = Clock::TicksToSeconds(dedupedTicks - parsedTicks);
+    result.indexSeconds = Clock::TicksToSeconds(endTicks - dedupedTicks);
+    result.totalSeconds = Clock::TicksToSeconds(endTicks - startTicks);
+
+    EM_LOG_INFO(
+        "Imported {0}: {1} triangles, {2} vertices ({3} merged) in {4:.1f} ms, {5:.0f} MB/s over {6} chunks on {7} threads",
+        path,
+        result.triangles,
+        result.vertices,
+        result.positions - result.vertices,
+        result.totalSeconds * 1000.0,
+        result.megabytesPerSecond(),
+        result.chunks,
+        result.threads);
+
+    if (stats)
+        *stats = result;
+    return true;
+}
+
+} // namespace ember
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "LlyModel.hpp"
+
+namespace ember
+{
+
+// Wavefront OBJ importer producing LlyModel geometry. The file is mapped and
+// split into chunks at line boundaries, every chunk is parsed by a job on
+// its own, so a big file is parsed by all the job system workers at once.
+// Without an initialized job system everything runs on the calling thread.
+//
+// Only what LlyModel::Vertex can hold is read: x and y of every "v" line,
+// plus the "v x y z r g b" color extension (white when missing). Faces are
+// triangulated as fans, texture coordinate and normal indices are skipped.
+// Vertices that come out identical are merged and shared through the index
+// buffer.
+class LlyObjLoader
+{
+public:
+    struct Stats
+    {
+        uint64_t bytes = 0;
+        uint32_t chunks = 0;
+        uint32_t threads = 0;
+        uint32_t positions = 0;
+        uint32_t triangles = 0;
+        // After merging identical vertices
+        uint32_t vertices = 0;
+        double parseSeconds = 0.0;
+        double dedupSeconds = 0.0;
+        double indexSeconds = 0.0;
+        double totalSeconds = 0.0;
+
+        double megabytesPerSecond() const
+        {
+            return totalSeconds > 0.0 ? bytes / (1024.0 * 1024.0) / totalSeconds : 0.0;
+        }
+    };
+
+    // Smallest chunk handed to a job, smaller files are parsed in one piece
+    static constexpr uint64_t MIN_CHUNK_SIZE = 256 * 1024;
+
+    // Returns false and logs why if the file can't be read or refers to
+    // vertices it doesn't have. Logs the throughput when it succeeds.
+    static bool load(
+        const char* path,
+        std::vector<LlyModel::Vertex>& vertices,
+        std::vector<uint32_t>& indices,
+        Stats* stats = nullptr);
+};
+
+} // namespace ember
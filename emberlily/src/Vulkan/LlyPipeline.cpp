@@ -1,6 +1,8 @@
 #include "LlyPipeline.hpp"
 
 #include <fstream>
+#include <stdexcept>
+
 #include "Core/Asserts.hpp"
 
 namespace ember
@@ -85,6 +87,8 @@ void LlyPipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo)
     configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
     configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
     configInfo.dynamicStateInfo.flags = 0;
+
+    configInfo.vertexFormat = VertexFormat::Float;
 }
 
 LlyPipeline::LlyPipeline(
@@ -92,17 +96,21 @@ LlyPipeline::LlyPipeline(
     const PipelineConfigInfo& configInfo,
     const std::string& vertFilepath,
     const std::string& fragFilepath)
-    : device_(device)
+    : device_(device), vertexFormat_(configInfo.vertexFormat)
 {
+    static uint32_t currentId = 0;
+    id_ = currentId++;
+
     createGraphicsPipeline(configInfo, vertFilepath, fragFilepath);
 }
 
 LlyPipeline::~LlyPipeline()
 {
-    vkDestroyShaderModule(device_->device(), vertShaderModule_, nullptr);
-    vkDestroyShaderModule(device_->device(), fragShaderModule_, nullptr);
+    const VkAllocationCallbacks* allocator = device_->hostAllocator(MemoryTag::Pipelines);
+    vkDestroyShaderModule(device_->device(), vertShaderModule_, allocator);
+    vkDestroyShaderModule(device_->device(), fragShaderModule_, allocator);
 
-    vkDestroyPipeline(device_->device(), graphicsPipeline_, nullptr);
+    vkDestroyPipeline(device_->device(), graphicsPipeline_, allocator);
 }
 
 void LlyPipeline::bind(VkCommandBuffer commandBuffer)
@@ -110,11 +118,17 @@ void LlyPipeline::bind(VkCommandBuffer commandBuffer)
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
 }
 
+void LlyPipeline::bind(LlyCommandRecorder& recorder)
+{
+    recorder.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
+}
+
 std::vector<char> LlyPipeline::readFile(const std::string& filepath)
 {
     std::ifstream file{filepath, std::ios::ate | std::ios::binary};
 
-    EM_CORE_ASSERT(file.is_open(), "Could not open shader file!");
+    if (!file.is_open())
+        throw std::runtime_error("Could not open shader file " + filepath);
 
     size_t fileSize = static_cast<size_t>(file.tellg());
     std::vector<char> buffer(fileSize);
@@ -154,8 +168,8 @@ void LlyPipeline::createGraphicsPipeline(
     shaderStages[1].pNext = nullptr;
     shaderStages[1].pSpecializationInfo = nullptr;
 
-    auto bindingDesctriptions = LlyModel::Vertex::getBindingDescriptions();
-    auto atttributeDescriptions = LlyModel::Vertex::getAttributeDescriptions();
+    auto bindingDesctriptions = getVertexBindingDescriptions(configInfo.vertexFormat);
+    auto atttributeDescriptions = getVertexAttributeDescriptions(configInfo.vertexFormat);
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(atttributeDescriptions.size());
@@ -183,8 +197,10 @@ void LlyPipeline::createGraphicsPipeline(
     pipelineInfo.basePipelineIndex = -1;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    VkResult ok = vkCreateGraphicsPipelines(device_->device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline_);
-    EM_CORE_ASSERT(ok == VK_SUCCESS, "Could not create graphics pipeline!");
+    VkResult ok = vkCreateGraphicsPipelines(
+        device_->device(), VK_NULL_HANDLE, 1, &pipelineInfo, device_->hostAllocator(MemoryTag::Pipelines), &graphicsPipeline_);
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Could not create graphics pipeline!");
 }
 
 void LlyPipeline::createShaderModule(
@@ -196,8 +212,9 @@ void LlyPipeline::createShaderModule(
     createInfo.codeSize = code.size();
     createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
 
-    VkResult ok = vkCreateShaderModule(device_->device(), &createInfo, nullptr, shaderModule);
-    EM_CORE_ASSERT(ok == VK_SUCCESS, "Failed to create shader module");
+    VkResult ok = vkCreateShaderModule(device_->device(), &createInfo, device_->hostAllocator(MemoryTag::Pipelines), shaderModule);
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Failed to create shader module");
 }
 
 } // namespace ember
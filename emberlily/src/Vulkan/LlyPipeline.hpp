@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 
+#include "LlyCommandRecorder.hpp"
 #include "LlyDevice.hpp"
 #include "LlyModel.hpp"
 
@@ -23,6 +24,9 @@ struct PipelineConfigInfo
     VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
     std::vector<VkDynamicState> dynamicStateEnables;
     VkPipelineDynamicStateCreateInfo dynamicStateInfo;
+    // Vertex layout the pipeline reads, only models stored in it can be
+    // drawn with the pipeline
+    VertexFormat vertexFormat = VertexFormat::Float;
     VkPipelineLayout pipelineLayout = nullptr;
     VkRenderPass renderPass = nullptr;
     uint32_t subpass = 0;
@@ -46,6 +50,11 @@ public:
     LlyPipeline& operator=(const LlyPipeline&) = delete;
 
     void bind(VkCommandBuffer commandBuffer);
+    void bind(LlyCommandRecorder& recorder);
+
+    // Small per-pipeline id, used to group draws by pipeline when sorting
+    uint32_t getId() const { return id_; }
+    VertexFormat getVertexFormat() const { return vertexFormat_; }
 
 private:
     static std::vector<char> readFile(const std::string& filepath);
@@ -57,6 +66,8 @@ private:
     void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
 
     std::shared_ptr<LlyDevice> device_;
+    uint32_t id_ = 0;
+    VertexFormat vertexFormat_ = VertexFormat::Float;
     VkPipeline graphicsPipeline_;
     VkShaderModule vertShaderModule_;
     VkShaderModule fragShaderModule_;
@@ -0,0 +1,213 @@
+#include "LlyPipelineStatistics.hpp"
+
+#include <stdexcept>
+
+#include "Core/Asserts.hpp"
+
+namespace ember
+{
+
+// Order of the values a statistics query returns, by bit position
+static constexpr VkQueryPipelineStatisticFlags STATISTICS =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+static constexpr uint32_t STATISTIC_COUNT = 6;
+
+LlyPipelineStatistics::Counters& LlyPipelineStatistics::Counters::operator+=(const Counters& other)
+{
+    inputVertices += other.inputVertices;
+    inputPrimitives += other.inputPrimitives;
+    vertexInvocations += other.vertexInvocations;
+    clippingInvocations += other.clippingInvocations;
+    clippingPrimitives += other.clippingPrimitives;
+    fragmentInvocations += other.fragmentInvocations;
+    samplesPassed += other.samplesPassed;
+    groups += other.groups;
+    return *this;
+}
+
+LlyPipelineStatistics::Counters& LlyPipelineStatistics::Counters::operator-=(const Counters& other)
+{
+    inputVertices -= other.inputVertices;
+    inputPrimitives -= other.inputPrimitives;
+    vertexInvocations -= other.vertexInvocations;
+    clippingInvocations -= other.clippingInvocations;
+    clippingPrimitives -= other.clippingPrimitives;
+    fragmentInvocations -= other.fragmentInvocations;
+    samplesPassed -= other.samplesPassed;
+    groups -= other.groups;
+    return *this;
+}
+
+LlyPipelineStatistics::LlyPipelineStatistics(std::shared_ptr<LlyDevice> device, uint32_t framesInFlight)
+    : device_(device), slots_(framesInFlight)
+{
+    const uint32_t queryCount = framesInFlight * MAX_GROUPS_PER_FRAME;
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryCount = queryCount;
+
+    if (device_->enabledFeatures.pipelineStatisticsQuery) {
+        poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        poolInfo.pipelineStatistics = STATISTICS;
+        VkResult ok = vkCreateQueryPool(device_->device(), &poolInfo, nullptr, &statisticsPool_);
+        if (ok != VK_SUCCESS)
+            throw std::runtime_error("Could not create pipeline statistics query pool!");
+    } else {
+        EM_LOG_WARN("Device doesn't support pipeline statistics queries, only counting samples passed");
+    }
+
+    // Occlusion queries are core, only the exact count is optional
+    poolInfo.queryType = VK_QUERY_TYPE_OCCLUSION;
+    poolInfo.pipelineStatistics = 0;
+    VkResult ok = vkCreateQueryPool(device_->device(), &poolInfo, nullptr, &occlusionPool_);
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Could not create occlusion query pool!");
+
+    if (device_->enabledFeatures.occlusionQueryPrecise)
+        occlusionFlags_ = VK_QUERY_CONTROL_PRECISE_BIT;
+
+    // Values plus availability of the largest query of a slice
+    results_.resize(MAX_GROUPS_PER_FRAME * (STATISTIC_COUNT + 1));
+}
+
+LlyPipelineStatistics::~LlyPipelineStatistics()
+{
+    if (statisticsPool_ != VK_NULL_HANDLE)
+        vkDestroyQueryPool(device_->device(), statisticsPool_, nullptr);
+    vkDestroyQueryPool(device_->device(), occlusionPool_, nullptr);
+}
+
+void LlyPipelineStatistics::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameSlot)
+{
+    EM_CORE_ASSERT(frameSlot < slots_.size(), "Frame slot out of range");
+
+    collect(frameSlot);
+
+    commandBuffer_ = commandBuffer;
+    frameSlot_ = frameSlot;
+    slots_[frameSlot].groups = 0;
+
+    const uint32_t firstQuery = frameSlot * MAX_GROUPS_PER_FRAME;
+    if (hasPipelineStatistics())
+        vkCmdResetQueryPool(commandBuffer, statisticsPool_, firstQuery, MAX_GROUPS_PER_FRAME);
+    vkCmdResetQueryPool(commandBuffer, occlusionPool_, firstQuery, MAX_GROUPS_PER_FRAME);
+}
+
+void LlyPipelineStatistics::beginGroup()
+{
+    EM_CORE_ASSERT(!groupOpen_, "Draw groups can't nest");
+    groupOpen_ = true;
+
+    // Out of queries, the rest of the frame isn't counted
+    FrameSlot& slot = slots_[frameSlot_];
+    groupCounted_ = slot.groups < MAX_GROUPS_PER_FRAME;
+    if (!groupCounted_)
+        return;
+
+    const uint32_t query = frameSlot_ * MAX_GROUPS_PER_FRAME + slot.groups;
+    if (hasPipelineStatistics())
+        vkCmdBeginQuery(commandBuffer_, statisticsPool_, query, 0);
+    vkCmdBeginQuery(commandBuffer_, occlusionPool_, query, occlusionFlags_);
+}
+
+void LlyPipelineStatistics::endGroup()
+{
+    EM_CORE_ASSERT(groupOpen_, "Draw group ended without being begun");
+    groupOpen_ = false;
+
+    if (!groupCounted_)
+        return;
+
+    FrameSlot& slot = slots_[frameSlot_];
+    const uint32_t query = frameSlot_ * MAX_GROUPS_PER_FRAME + slot.groups;
+    if (hasPipelineStatistics())
+        vkCmdEndQuery(commandBuffer_, statisticsPool_, query);
+    vkCmdEndQuery(commandBuffer_, occlusionPool_, query);
+    slot.groups++;
+}
+
+void LlyPipelineStatistics::endFrame()
+{
+    EM_CORE_ASSERT(!groupOpen_, "Draw group still open at the end of the frame");
+
+    FrameSlot& slot = slots_[frameSlot_];
+    slot.pending = slot.groups > 0;
+}
+
+LlyPipelineStatistics::Counters LlyPipelineStatistics::getAverage() const
+{
+    const uint64_t frames = framesCollected_ < AVERAGE_FRAMES ? framesCollected_ : AVERAGE_FRAMES;
+    if (frames == 0)
+        return Counters{};
+
+    Counters average = historySum_;
+    average.inputVertices /= frames;
+    average.inputPrimitives /= frames;
+    average.vertexInvocations /= frames;
+    average.clippingInvocations /= frames;
+    average.clippingPrimitives /= frames;
+    average.fragmentInvocations /= frames;
+    average.samplesPassed /= frames;
+    average.groups /= frames;
+    return average;
+}
+
+void LlyPipelineStatistics::collect(uint32_t frameSlot)
+{
+    FrameSlot& slot = slots_[frameSlot];
+    if (!slot.pending)
+        return;
+    slot.pending = false;
+
+    const uint32_t firstQuery = frameSlot * MAX_GROUPS_PER_FRAME;
+    const VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+
+    // No wait flag, a frame that isn't done yet is skipped
+    Counters frame;
+    frame.groups = slot.groups;
+
+    if (hasPipelineStatistics()) {
+        const VkDeviceSize stride = (STATISTIC_COUNT + 1) * sizeof(uint64_t);
+        VkResult result = vkGetQueryPoolResults(
+            device_->device(), statisticsPool_, firstQuery, slot.groups,
+            slot.groups * stride, results_.data(), stride, flags);
+        if (result != VK_SUCCESS)
+            return;
+
+        for (uint32_t i = 0; i < slot.groups; i++) {
+            const uint64_t* values = &results_[i * (STATISTIC_COUNT + 1)];
+            frame.inputVertices += values[0];
+            frame.inputPrimitives += values[1];
+            frame.vertexInvocations += values[2];
+            frame.clippingInvocations += values[3];
+            frame.clippingPrimitives += values[4];
+            frame.fragmentInvocations += values[5];
+        }
+    }
+
+    const VkDeviceSize stride = 2 * sizeof(uint64_t);
+    VkResult result = vkGetQueryPoolResults(
+        device_->device(), occlusionPool_, firstQuery, slot.groups,
+        slot.groups * stride, results_.data(), stride, flags);
+    if (result != VK_SUCCESS)
+        return;
+
+    for (uint32_t i = 0; i < slot.groups; i++)
+        frame.samplesPassed += results_[i * 2];
+
+    Counters& oldest = history_[framesCollected_ % AVERAGE_FRAMES];
+    historySum_ -= oldest;
+    oldest = frame;
+    historySum_ += frame;
+
+    lastFrame_ = frame;
+    framesCollected_++;
+}
+
+} // namespace ember
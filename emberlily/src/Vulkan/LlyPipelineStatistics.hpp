@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "LlyDevice.hpp"
+
+namespace ember
+{
+
+// Counts what the GPU did for each group of draws: vertices, primitives and
+// shader invocations through a pipeline statistics query, samples that
+// passed the depth test through an occlusion query. Fragment invocations
+// against samples passed and the framebuffer size show the overdraw.
+//
+// Like LlyGpuProfiler every frame in flight owns a slice of the pools, read
+// back without waiting when the slot comes around again.
+class LlyPipelineStatistics
+{
+public:
+    static constexpr uint32_t MAX_GROUPS_PER_FRAME = 64;
+    // Frames the rolling average runs over
+    static constexpr uint32_t AVERAGE_FRAMES = 60;
+
+    struct Counters
+    {
+        uint64_t inputVertices = 0;
+        uint64_t inputPrimitives = 0;
+        uint64_t vertexInvocations = 0;
+        uint64_t clippingInvocations = 0;
+        uint64_t clippingPrimitives = 0;
+        uint64_t fragmentInvocations = 0;
+        uint64_t samplesPassed = 0;
+        uint64_t groups = 0;
+
+        Counters& operator+=(const Counters& other);
+        Counters& operator-=(const Counters& other);
+    };
+
+    LlyPipelineStatistics(std::shared_ptr<LlyDevice> device, uint32_t framesInFlight);
+    ~LlyPipelineStatistics();
+
+    LlyPipelineStatistics(const LlyPipelineStatistics&) = delete;
+    LlyPipelineStatistics& operator=(const LlyPipelineStatistics&) = delete;
+
+    // Without the pipelineStatisticsQuery feature only the occlusion query
+    // runs and the other counters stay at 0
+    bool hasPipelineStatistics() const { return statisticsPool_ != VK_NULL_HANDLE; }
+
+    // Call right after vkBeginCommandBuffer, outside of a render pass
+    void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameSlot);
+    // A group must begin and end inside the same subpass, groups can't nest
+    void beginGroup();
+    void endGroup();
+    void endFrame();
+
+    // Last frame that came back from the GPU and the average of the last
+    // AVERAGE_FRAMES of them
+    const Counters& getLastFrame() const { return lastFrame_; }
+    Counters getAverage() const;
+    // Frames read back so far
+    uint64_t getFramesCollected() const { return framesCollected_; }
+
+private:
+    struct FrameSlot
+    {
+        uint32_t groups = 0;
+        bool pending = false;
+    };
+
+    void collect(uint32_t frameSlot);
+
+    std::shared_ptr<LlyDevice> device_;
+    VkQueryPool statisticsPool_ = VK_NULL_HANDLE;
+    VkQueryPool occlusionPool_ = VK_NULL_HANDLE;
+    VkQueryControlFlags occlusionFlags_ = 0;
+
+    std::vector<FrameSlot> slots_;
+    std::vector<uint64_t> results_;
+
+    Counters lastFrame_;
+    std::array<Counters, AVERAGE_FRAMES> history_{};
+    Counters historySum_;
+    uint64_t framesCollected_ = 0;
+
+    // Frame being recorded
+    VkCommandBuffer commandBuffer_ = VK_NULL_HANDLE;
+    uint32_t frameSlot_ = 0;
+    bool groupOpen_ = false;
+    bool groupCounted_ = false;
+};
+
+} // namespace ember
@@ -0,0 +1,129 @@
+#include "LlyRenderQueue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "LlyModel.hpp"
+#include "LlyPipeline.hpp"
+
+namespace ember
+{
+
+uint64_t LlyRenderQueue::makeSortKey(uint32_t layer, uint32_t pipelineId, uint32_t modelId, float depth)
+{
+    constexpr uint64_t depthMax = (1ull << DEPTH_BITS) - 1;
+    const float clampedDepth = std::min(std::max(depth, 0.0f), 1.0f);
+    const uint64_t quantizedDepth = static_cast<uint64_t>(clampedDepth * static_cast<float>(depthMax));
+
+    // Ids wider than their field wrap around. That only costs some grouping,
+    // binding is still decided by comparing the actual objects.
+    uint64_t key = static_cast<uint64_t>(layer & ((1u << LAYER_BITS) - 1));
+    key = (key << PIPELINE_BITS) | (pipelineId & ((1u << PIPELINE_BITS) - 1));
+    key = (key << MODEL_BITS) | (modelId & ((1u << MODEL_BITS) - 1));
+    key = (key << DEPTH_BITS) | quantizedDepth;
+    return key;
+}
+
+void LlyRenderQueue::clear()
+{
+    packets_.clear();
+}
+
+void LlyRenderQueue::submit(LlyPipeline* pipeline, LlyModel* model, uint32_t objectIndex, uint32_t layer, float depth)
+{
+    // A stride that doesn't match the vertex buffer reads past its end, and
+    // robust buffer access is off
+    if (pipeline->getVertexFormat() != model->getVertexFormat())
+        throw std::runtime_error("Pipeline and model vertex formats don't match");
+
+    RenderPacket packet{};
+    packet.sortKey = makeSortKey(layer, pipeline->getId(), model->getId(), depth);
+    packet.pipeline = pipeline;
+    packet.model = model;
+    packet.objectIndex = objectIndex;
+    packets_.push_back(packet);
+}
+
+void LlyRenderQueue::sort()
+{
+    stats_ = Stats{};
+    stats_.drawCount = static_cast<uint32_t>(packets_.size());
+
+    countBinds(stats_.unsortedPipelineBinds, stats_.unsortedModelBinds);
+    radixSort();
+    countBinds(stats_.pipelineBinds, stats_.modelBinds);
+}
+
+void LlyRenderQueue::countBinds(uint32_t& pipelineBinds, uint32_t& modelBinds) const
+{
+    pipelineBinds = 0;
+    modelBinds = 0;
+
+    const LlyPipeline* lastPipeline = nullptr;
+    const LlyModel* lastModel = nullptr;
+    for (const auto& packet : packets_) {
+        if (packet.pipeline != lastPipeline) {
+            lastPipeline = packet.pipeline;
+            pipelineBinds++;
+        }
+        if (packet.model != lastModel) {
+            lastModel = packet.model;
+            modelBinds++;
+        }
+    }
+}
+
+void LlyRenderQueue::radixSort()
+{
+    constexpr uint32_t digitBits = 8;
+    constexpr uint32_t digitCount = 64 / digitBits;
+    constexpr uint32_t bucketCount = 1u << digitBits;
+
+    const size_t count = packets_.size();
+    if (count < 2)
+        return;
+
+    scratch_.resize(count);
+
+    // Build the histograms of every digit in a single pass over the keys
+    std::array<std::array<uint32_t, bucketCount>, digitCount> histograms{};
+    for (const auto& packet : packets_) {
+        for (uint32_t digit = 0; digit < digitCount; digit++) {
+            histograms[digit][(packet.sortKey >> (digit * digitBits)) & (bucketCount - 1)]++;
+        }
+    }
+
+    RenderPacket* src = packets_.data();
+    RenderPacket* dst = scratch_.data();
+
+    // Stable LSD passes, least significant digit first
+    for (uint32_t digit = 0; digit < digitCount; digit++) {
+        auto& histogram = histograms[digit];
+        const uint32_t shift = digit * digitBits;
+
+        // All keys share this digit, the pass wouldn't move anything
+        if (histogram[(src[0].sortKey >> shift) & (bucketCount - 1)] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (auto& bucket : histogram) {
+            const uint32_t bucketSize = bucket;
+            bucket = offset;
+            offset += bucketSize;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            dst[histogram[(src[i].sortKey >> shift) & (bucketCount - 1)]++] = src[i];
+        }
+
+        std::swap(src, dst);
+        stats_.sortPasses++;
+    }
+
+    // After an odd number of passes the sorted packets live in the scratch buffer
+    if (src != packets_.data())
+        packets_.swap(scratch_);
+}
+
+} // namespace ember
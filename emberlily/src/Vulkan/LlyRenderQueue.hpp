@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ember
+{
+
+class LlyModel;
+class LlyPipeline;
+
+// A single draw waiting to be recorded. The sort key packs the state the draw
+// needs so that sorting the keys groups draws sharing a pipeline and a model.
+struct RenderPacket
+{
+    uint64_t sortKey;
+    LlyPipeline* pipeline;
+    LlyModel* model;
+    uint32_t objectIndex;
+};
+
+class LlyRenderQueue
+{
+public:
+    // Key layout, most significant bits first:
+    // [63..56] layer | [55..40] pipeline id | [39..24] model id | [23..0] depth
+    static constexpr uint32_t LAYER_BITS = 8;
+    static constexpr uint32_t PIPELINE_BITS = 16;
+    static constexpr uint32_t MODEL_BITS = 16;
+    static constexpr uint32_t DEPTH_BITS = 24;
+
+    struct Stats
+    {
+        uint32_t drawCount = 0;
+        uint32_t sortPasses = 0;
+
+        // Binds needed when drawing in sorted order
+        uint32_t pipelineBinds = 0;
+        uint32_t modelBinds = 0;
+
+        // Binds that submission order would have needed
+        uint32_t unsortedPipelineBinds = 0;
+        uint32_t unsortedModelBinds = 0;
+
+        uint32_t pipelineBindsAvoided() const { return unsortedPipelineBinds - pipelineBinds; }
+        uint32_t modelBindsAvoided() const { return unsortedModelBinds - modelBinds; }
+    };
+
+    static uint64_t makeSortKey(uint32_t layer, uint32_t pipelineId, uint32_t modelId, float depth);
+
+    LlyRenderQueue() = default;
+
+    // Delete copy contructors
+    LlyRenderQueue(const LlyRenderQueue&) = delete;
+    LlyRenderQueue& operator=(const LlyRenderQueue&) = delete;
+
+    void clear();
+    // Depth is expected in [0, 1], smaller values are drawn first inside a
+    // (layer, pipeline, model) group. Throws if the pipeline reads another
+    // vertex format than the model is stored in.
+    void submit(LlyPipeline* pipeline, LlyModel* model, uint32_t objectIndex, uint32_t layer = 0, float depth = 0.0f);
+    void sort();
+
+    const std::vector<RenderPacket>& packets() const { return packets_; }
+    const Stats& getStats() const { return stats_; }
+
+private:
+    void countBinds(uint32_t& pipelineBinds, uint32_t& modelBinds) const;
+    void radixSort();
+
+    std::vector<RenderPacket> packets_;
+    // Kept around between frames so sorting doesn't allocate once the queue has
+    // grown to the size of the scene
+    std::vector<RenderPacket> scratch_;
+    Stats stats_;
+};
+
+} // namespace ember
@@ -1,5 +1,9 @@
 #include "LlySwapChain.hpp"
 
+#include "Core/Clock.hpp"
+#include "Core/FlightRecorder.hpp"
+#include "Core/Profiler.hpp"
+
 // std
 #include <array>
 #include <cstdlib>
@@ -8,6 +12,7 @@
 #include <limits>
 #include <set>
 #include <stdexcept>
+#include <utility>
 
 namespace ember {
 
@@ -47,10 +52,15 @@ LlySwapChain::~LlySwapChain() {
     swapChain = nullptr;
   }
 
+  for (size_t i = 0; i < offscreenImageMemorys.size(); i++) {
+    vkDestroyImage(device->device(), swapChainImages[i], nullptr);
+    device->freeMemory(offscreenImageMemorys[i]);
+  }
+
   for (int i = 0; i < depthImages.size(); i++) {
     vkDestroyImageView(device->device(), depthImageViews[i], nullptr);
     vkDestroyImage(device->device(), depthImages[i], nullptr);
-    vkFreeMemory(device->device(), depthImageMemorys[i], nullptr);
+    device->freeMemory(depthImageMemorys[i]);
   }
 
   for (auto framebuffer : swapChainFramebuffers) {
@@ -68,12 +78,25 @@ LlySwapChain::~LlySwapChain() {
 }
 
 VkResult LlySwapChain::acquireNextImage(uint32_t *imageIndex) {
+  EM_PROFILE_FUNCTION();
+
+  const uint64_t start = Clock::Ticks();
   vkWaitForFences(
       device->device(),
       1,
       &inFlightFences[currentFrame],
       VK_TRUE,
       std::numeric_limits<uint64_t>::max());
+  const uint64_t waited = Clock::Ticks();
+
+  if (isHeadless()) {
+    *imageIndex = nextOffscreenImage;
+    nextOffscreenImage = (nextOffscreenImage + 1) % static_cast<uint32_t>(imageCount());
+
+    lastTimings = FrameTimings{};
+    lastTimings.fenceWaitTicks = waited - start;
+    return VK_SUCCESS;
+  }
 
   VkResult result = vkAcquireNextImageKHR(
       device->device(),
@@ -83,22 +106,42 @@ VkResult LlySwapChain::acquireNextImage(uint32_t *imageIndex) {
       VK_NULL_HANDLE,
       imageIndex);
 
+  lastTimings = FrameTimings{};
+  lastTimings.fenceWaitTicks = waited - start;
+  lastTimings.acquireTicks = Clock::Ticks() - waited;
+
   return result;
 }
 
 VkResult LlySwapChain::submitCommandBuffers(
-    const VkCommandBuffer *buffers, uint32_t *imageIndex) {
+    const VkCommandBuffer *buffers, uint32_t *imageIndex, VkSemaphore uploadSemaphore) {
+  EM_PROFILE_FUNCTION();
+
   if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
+    const uint64_t start = Clock::Ticks();
     vkWaitForFences(device->device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
+    lastTimings.fenceWaitTicks += Clock::Ticks() - start;
   }
   imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
 
   VkSubmitInfo submitInfo = {};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-  VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-  VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submitInfo.waitSemaphoreCount = 1;
+  // headless there is no acquire to wait for and no present to signal
+  const uint32_t semaphoreCount = isHeadless() ? 0 : 1;
+
+  VkSemaphore waitSemaphores[2];
+  VkPipelineStageFlags waitStages[2];
+  uint32_t waitCount = 0;
+  if (!isHeadless()) {
+    waitSemaphores[waitCount] = imageAvailableSemaphores[currentFrame];
+    waitStages[waitCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  }
+  if (uploadSemaphore != VK_NULL_HANDLE) {
+    waitSemaphores[waitCount] = uploadSemaphore;
+    waitStages[waitCount++] = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+  }
+  submitInfo.waitSemaphoreCount = waitCount;
   submitInfo.pWaitSemaphores = waitSemaphores;
   submitInfo.pWaitDstStageMask = waitStages;
 
@@ -106,15 +149,24 @@ VkResult LlySwapChain::submitCommandBuffers(
   submitInfo.pCommandBuffers = buffers;
 
   VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.signalSemaphoreCount = semaphoreCount;
   submitInfo.pSignalSemaphores = signalSemaphores;
 
+  const uint64_t submitStart = Clock::Ticks();
   vkResetFences(device->device(), 1, &inFlightFences[currentFrame]);
-  if (vkQueueSubmit(device->graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-      VK_SUCCESS) {
+  VkResult submitResult = vkQueueSubmit(device->graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]);
+  lastTimings.submitTicks = Clock::Ticks() - submitStart;
+  EM_RECORD("Queue submit frame {1} result {0}", submitResult, currentFrame);
+  if (submitResult != VK_SUCCESS) {
     throw std::runtime_error("failed to submit draw command buffer!");
   }
 
+  lastSubmittedImage = *imageIndex;
+  if (isHeadless()) {
+    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    return VK_SUCCESS;
+  }
+
   VkPresentInfoKHR presentInfo = {};
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -127,7 +179,10 @@ VkResult LlySwapChain::submitCommandBuffers(
 
   presentInfo.pImageIndices = imageIndex;
 
+  const uint64_t presentStart = Clock::Ticks();
   auto result = vkQueuePresentKHR(device->presentQueue(), &presentInfo);
+  lastTimings.presentTicks = Clock::Ticks() - presentStart;
+  EM_RECORD("Present image {1} result {0}", result, *imageIndex);
 
   currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 
@@ -135,6 +190,11 @@ VkResult LlySwapChain::submitCommandBuffers(
 }
 
 void LlySwapChain::createSwapChain() {
+  if (isHeadless()) {
+    createOffscreenImages();
+    return;
+  }
+
   SwapChainSupportDetails swapChainSupport = device->getSwapChainSupport();
 
   VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
@@ -195,6 +255,123 @@ void LlySwapChain::createSwapChain() {
   swapChainExtent = extent;
 }
 
+void LlySwapChain::createOffscreenImages() {
+  // same format the surface would most likely have given us, so pipelines
+  // and golden images behave the same with or without a window
+  swapChainImageFormat = device->findSupportedFormat(
+      {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB},
+      VK_IMAGE_TILING_OPTIMAL,
+      VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+  swapChainExtent = windowExtent;
+
+  swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+  offscreenImageMemorys.resize(MAX_FRAMES_IN_FLIGHT);
+
+  for (size_t i = 0; i < swapChainImages.size(); i++) {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = swapChainExtent.width;
+    imageInfo.extent.height = swapChainExtent.height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = swapChainImageFormat;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.flags = 0;
+
+    device->createImageWithInfo(
+        imageInfo,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        swapChainImages[i],
+        offscreenImageMemorys[i],
+        MemoryTag::SwapChain);
+  }
+}
+
+void LlySwapChain::readLastImage(std::vector<uint8_t> &rgba) {
+  if (!isHeadless()) {
+    throw std::runtime_error("only offscreen images can be read back!");
+  }
+
+  vkQueueWaitIdle(device->graphicsQueue());
+
+  const uint32_t width = swapChainExtent.width;
+  const uint32_t height = swapChainExtent.height;
+  const VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * 4;
+
+  VkBuffer stagingBuffer;
+  VkDeviceMemory stagingMemory;
+  device->createBuffer(
+      size,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      stagingBuffer,
+      stagingMemory,
+      MemoryTag::SwapChain);
+
+  VkCommandBuffer commandBuffer = device->beginSingleTimeCommands();
+
+  // the render pass left the image in TRANSFER_SRC, make its writes visible
+  // to the copy
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = swapChainImages[lastSubmittedImage];
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.layerCount = 1;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &barrier);
+
+  VkBufferImageCopy region{};
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.layerCount = 1;
+  region.imageExtent = {width, height, 1};
+  vkCmdCopyImageToBuffer(
+      commandBuffer,
+      swapChainImages[lastSubmittedImage],
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      stagingBuffer,
+      1,
+      &region);
+
+  device->endSingleTimeCommands(commandBuffer);
+
+  rgba.resize(static_cast<size_t>(size));
+  void *data;
+  vkMapMemory(device->device(), stagingMemory, 0, size, 0, &data);
+  memcpy(rgba.data(), data, static_cast<size_t>(size));
+  vkUnmapMemory(device->device(), stagingMemory);
+
+  if (swapChainImageFormat == VK_FORMAT_B8G8R8A8_SRGB) {
+    for (size_t i = 0; i < rgba.size(); i += 4) {
+      std::swap(rgba[i], rgba[i + 2]);
+    }
+  }
+
+  vkDestroyBuffer(device->device(), stagingBuffer, nullptr);
+  device->freeMemory(stagingMemory);
+}
+
 void LlySwapChain::createImageViews() {
   swapChainImageViews.resize(swapChainImages.size());
   for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -239,7 +416,9 @@ void LlySwapChain::createRenderPass() {
   colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  // only the final layout differs headless, the render passes stay compatible
+  colorAttachment.finalLayout =
+      isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
   VkAttachmentReference colorAttachmentRef = {};
   colorAttachmentRef.attachment = 0;
@@ -331,7 +510,8 @@ void LlySwapChain::createDepthResources() {
         imageInfo,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         depthImages[i],
-        depthImageMemorys[i]);
+        depthImageMemorys[i],
+        MemoryTag::SwapChain);
 
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
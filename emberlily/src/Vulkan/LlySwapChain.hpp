@@ -15,6 +15,14 @@ class LlySwapChain {
  public:
   static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
+  // Clock ticks spent blocked or in the driver during the last frame
+  struct FrameTimings {
+    uint64_t fenceWaitTicks = 0;  // in flight fence plus the image's fence
+    uint64_t acquireTicks = 0;
+    uint64_t submitTicks = 0;
+    uint64_t presentTicks = 0;
+  };
+
   LlySwapChain(std::shared_ptr<LlyDevice> deviceRef, VkExtent2D windowExtent);
   LlySwapChain(std::shared_ptr<LlyDevice> deviceRef, VkExtent2D windowExtent, 
     std::shared_ptr<LlySwapChain> previous);
@@ -31,6 +39,8 @@ class LlySwapChain {
   VkExtent2D getSwapChainExtent() { return swapChainExtent; }
   uint32_t width() { return swapChainExtent.width; }
   uint32_t height() { return swapChainExtent.height; }
+  // Frame in flight slot the next submit uses, 0 to MAX_FRAMES_IN_FLIGHT - 1
+  size_t getCurrentFrame() { return currentFrame; }
 
   float extentAspectRatio() {
     return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
@@ -38,11 +48,23 @@ class LlySwapChain {
   VkFormat findDepthFormat();
 
   VkResult acquireNextImage(uint32_t *imageIndex);
-  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+  // uploadSemaphore, if set, is waited on before vertex input, e.g. the
+  // asset streamer's copies the frame draws from
+  VkResult submitCommandBuffers(
+      const VkCommandBuffer *buffers, uint32_t *imageIndex, VkSemaphore uploadSemaphore = VK_NULL_HANDLE);
+
+  // On a headless device the images are plain offscreen images, acquire
+  // cycles through them and present does nothing
+  bool isHeadless() { return device->isHeadless(); }
+  // Headless only: waits for the GPU and copies the last submitted image,
+  // tightly packed RGBA8
+  void readLastImage(std::vector<uint8_t> &rgba);
+  const FrameTimings &getLastTimings() const { return lastTimings; }
 
  private:
   void init();
   void createSwapChain();
+  void createOffscreenImages();
   void createImageViews();
   void createDepthResources();
   void createRenderPass();
@@ -67,11 +89,15 @@ class LlySwapChain {
   std::vector<VkImageView> depthImageViews;
   std::vector<VkImage> swapChainImages;
   std::vector<VkImageView> swapChainImageViews;
+  // owned by us instead of the swapchain when headless
+  std::vector<VkDeviceMemory> offscreenImageMemorys;
+  uint32_t nextOffscreenImage = 0;
+  uint32_t lastSubmittedImage = 0;
 
   std::shared_ptr<LlyDevice> device;
   VkExtent2D windowExtent;
 
-  VkSwapchainKHR swapChain;
+  VkSwapchainKHR swapChain = VK_NULL_HANDLE;
   std::shared_ptr<LlySwapChain> oldSwapChain_;
 
   std::vector<VkSemaphore> imageAvailableSemaphores;
@@ -79,6 +105,7 @@ class LlySwapChain {
   std::vector<VkFence> inFlightFences;
   std::vector<VkFence> imagesInFlight;
   size_t currentFrame = 0;
+  FrameTimings lastTimings;
 };
 
 }  // namespace ember
\ No newline at end of file
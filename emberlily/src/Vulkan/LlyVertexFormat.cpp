@@ -0,0 +1,103 @@
+#include "LlyVertexFormat.hpp"
+
+#include <cstring>
+
+namespace ember
+{
+
+namespace
+{
+
+struct FormatInfo
+{
+    const char* name;
+    uint32_t stride;
+    VkFormat position;
+    VkFormat color;
+    uint32_t colorOffset;
+};
+
+const FormatInfo formats[static_cast<uint32_t>(VertexFormat::Count)] = {
+    {"float", 20, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, 8},
+    {"half", 8, VK_FORMAT_R16G16_SFLOAT, VK_FORMAT_R8G8B8A8_UNORM, 4},
+    {"snorm16", 8, VK_FORMAT_R16G16_SNORM, VK_FORMAT_R8G8B8A8_UNORM, 4},
+};
+
+} // namespace
+
+const char* getVertexFormatName(VertexFormat format)
+{
+    return format < VertexFormat::Count ? formats[static_cast<uint32_t>(format)].name : "unknown";
+}
+
+uint32_t getVertexStride(VertexFormat format)
+{
+    return formats[static_cast<uint32_t>(format)].stride;
+}
+
+std::vector<VkVertexInputBindingDescription> getVertexBindingDescriptions(VertexFormat format)
+{
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+    bindingDescriptions[0].binding = 0;
+    bindingDescriptions[0].stride = getVertexStride(format);
+    bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions(VertexFormat format)
+{
+    const FormatInfo& info = formats[static_cast<uint32_t>(format)];
+
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
+    attributeDescriptions[0].binding = 0;
+    attributeDescriptions[0].location = 0;
+    attributeDescriptions[0].format = info.position;
+    attributeDescriptions[0].offset = 0;
+
+    attributeDescriptions[1].binding = 0;
+    attributeDescriptions[1].location = 1;
+    attributeDescriptions[1].format = info.color;
+    attributeDescriptions[1].offset = info.colorOffset;
+
+    return attributeDescriptions;
+}
+
+uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    // Infinity stays infinity, NaN stays a quiet NaN
+    if (((bits >> 23) & 0xFF) == 0xFF)
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    if (exponent >= 31)
+        return static_cast<uint16_t>(sign | 0x7C00);
+
+    // Too small for a normal half, the implicit one becomes explicit and
+    // shifts down into a subnormal
+    uint32_t shift = 13;
+    uint32_t half;
+    if (exponent <= 0) {
+        if (exponent < -10)
+            return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000;
+        shift = static_cast<uint32_t>(14 - exponent);
+        half = mantissa >> shift;
+    } else {
+        half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> shift);
+    }
+
+    // A carry out of the mantissa correctly bumps the exponent, up to infinity
+    const uint32_t rest = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (half & 1)))
+        half++;
+    return static_cast<uint16_t>(sign | half);
+}
+
+} // namespace ember
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace ember
+{
+
+// Vertex layouts a model can be stored in, picked per mesh. All of them feed
+// the same shader inputs: vertex fetch turns half floats and normalized
+// integers into floats, a vec3 color input reads rgb of an RGBA8 color.
+enum class VertexFormat : uint32_t
+{
+    // vec2 position, vec3 color, 32 bit floats. 20 bytes, LlyModel::Vertex.
+    Float,
+    // Half float position, RGBA8 color. 8 bytes, positions keep about three
+    // significant digits.
+    Half,
+    // 16 bit snorm position within the mesh bounds, RGBA8 color. 8 bytes,
+    // 1/65535 of the bounds everywhere. Decoded by PositionDecode.
+    Snorm16,
+    Count
+};
+
+// Maps stored snorm positions back to model space: position * scale + offset.
+// The identity for the float layouts.
+struct PositionDecode
+{
+    float scale[2];
+    float offset[2];
+};
+
+constexpr PositionDecode IDENTITY_POSITION_DECODE = {{1.0f, 1.0f}, {0.0f, 0.0f}};
+
+const char* getVertexFormatName(VertexFormat format);
+uint32_t getVertexStride(VertexFormat format);
+std::vector<VkVertexInputBindingDescription> getVertexBindingDescriptions(VertexFormat format);
+std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions(VertexFormat format);
+
+// Round to nearest even, overflow goes to infinity
+uint16_t floatToHalf(float value);
+
+} // namespace ember
@@ -1,8 +1,6 @@
 #include "LlyWindow.hpp"
 
-#include "Events/ApplicationEvent.hpp"
-#include "Events/KeyEvent.hpp"
-#include "Events/MouseEvent.hpp"
+#include <stdexcept>
 
 namespace ember
 {
@@ -19,9 +17,11 @@ LlyWindow::LlyWindow(const std::string& title, int width, int height)
     data_.height = height;
 
     EM_LOG_INFO("Creating window {0} ({1}, {2})", data_.title, data_.width, data_.height);
+    MemoryTracker::RecordAllocation(MemoryDomain::Cpu, MemoryTag::Events, sizeof(EventQueue));
 
     int success = glfwInit();
-    EM_CORE_ASSERT(success, "Could not initialize GLFW!");
+    if (!success)
+        throw std::runtime_error("Could not initialize GLFW!");
 
     glfwSetErrorCallback(GLFWErrorCallback);
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -50,16 +50,14 @@ LlyWindow::LlyWindow(const std::string& title, int width, int height)
         data.height = height;
         data.windowResized = true;
 
-        WindowResizeEvent event(width, height);
-        data.eventCallback(event);
+        data.eventQueue.Push(QueuedEvent::WindowResize(width, height));
     });
 
     glfwSetWindowCloseCallback(window_, [](GLFWwindow* window)
     {
         WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
 
-        WindowCloseEvent event;
-        data.eventCallback(event);
+        data.eventQueue.Push(QueuedEvent::WindowClose());
     });
 
     glfwSetKeyCallback(window_, [](GLFWwindow* window, int key, int scancode, int action, int modes)
@@ -69,24 +67,15 @@ LlyWindow::LlyWindow(const std::string& title, int width, int height)
         switch (action)
         {
         case GLFW_PRESS:
-        {
-            KeyPressedEvent event((KeyCode)key);
-            data.eventCallback(event);
+            data.eventQueue.Push(QueuedEvent::Key(EventType::KeyPressed, (KeyCode)key));
             break;
-        }
         case GLFW_RELEASE:
-        {
-            KeyReleasedEvent event((KeyCode)key);
-            data.eventCallback(event);
+            data.eventQueue.Push(QueuedEvent::Key(EventType::KeyReleased, (KeyCode)key));
             break;
-        }
         case GLFW_REPEAT:
-        {
-            KeyRepeatEvent event((KeyCode)key);
-            data.eventCallback(event);
+            data.eventQueue.Push(QueuedEvent::Key(EventType::KeyRepeat, (KeyCode)key));
             break;
         }
-        }
     });
 
     glfwSetMouseButtonCallback(window_, [](GLFWwindow* window, int button, int action, int modes)
@@ -96,34 +85,26 @@ LlyWindow::LlyWindow(const std::string& title, int width, int height)
         switch (action)
         {
         case GLFW_PRESS:
-        {
-            MouseButtonPressedEvent event(button);
-            data.eventCallback(event);
+            data.eventQueue.Push(QueuedEvent::MouseButton(EventType::MouseButtonPressed, button));
             break;
-        }
         case GLFW_RELEASE:
-        {
-            MouseButtonReleasedEvent event(button);
-            data.eventCallback(event);
+            data.eventQueue.Push(QueuedEvent::MouseButton(EventType::MouseButtonReleased, button));
             break;
         }
-        }
     });
 
     glfwSetScrollCallback(window_, [](GLFWwindow* window, double xOffset, double yOffset)
     {
         WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
 
-        MouseScrolledEvent event((float)xOffset, (float)yOffset);
-        data.eventCallback(event);
+        data.eventQueue.Push(QueuedEvent::Mouse(EventType::MouseScrolled, (float)xOffset, (float)yOffset));
     });
 
     glfwSetCursorPosCallback(window_, [](GLFWwindow* window, double xPos, double yPos)
     {
         WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
 
-        MouseMovedEvent event((float)xPos, (float)yPos);
-        data.eventCallback(event);
+        data.eventQueue.Push(QueuedEvent::Mouse(EventType::MouseMoved, (float)xPos, (float)yPos));
     });
 }
 
@@ -131,6 +112,7 @@ LlyWindow::~LlyWindow()
 {
     glfwDestroyWindow(window_);
     glfwTerminate();
+    MemoryTracker::RecordFree(MemoryDomain::Cpu, MemoryTag::Events, sizeof(EventQueue));
 }
 
 void LlyWindow::update()
@@ -153,10 +135,8 @@ void LlyWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR *surface)
 {
     VkResult ok = glfwCreateWindowSurface(instance, window_, nullptr, surface);
 
-    EM_CORE_ASSERT(
-        ok == VK_SUCCESS,
-        "Unable to create vulkan surface for GLFW window!"
-    );
+    if (ok != VK_SUCCESS)
+        throw std::runtime_error("Unable to create vulkan surface for GLFW window!");
 }
 
 } // namespace ember
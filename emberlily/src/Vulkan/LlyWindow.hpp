@@ -1,13 +1,13 @@
 #pragma once
 
 #include <string>
-#include <functional>
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #include "Core/Asserts.hpp"
 #include "Core/Defines.hpp"
-#include "Events/Event.hpp"
+#include "Core/MemoryTracker.hpp"
+#include "Events/EventQueue.hpp"
 
 namespace ember
 {
@@ -15,7 +15,6 @@ namespace ember
 class LlyWindow
 {
 public:
-    using EventCallbackFn = std::function<void(Event&)>;
     LlyWindow() {}
     LlyWindow(const std::string& title, int width, int height);
     ~LlyWindow(); 
@@ -35,8 +34,10 @@ public:
     inline bool wasWindowResized() const { return data_.windowResized; }
     inline void resetWindowResizedFlag() { data_.windowResized = false; }
 
+    // Events received since the last drain, filled by glfwPollEvents
+    inline EventQueue& getEventQueue() { return data_.eventQueue; }
+
     // Window attributes
-    inline void SetEventCallback(const EventCallbackFn& callback) { data_.eventCallback = callback; }
     void setVSync(bool enabled);
     inline bool isVSync() const { return data_.VSync; }
 
@@ -51,7 +52,7 @@ private:
         bool VSync;
         bool windowResized = false;
 
-        EventCallbackFn eventCallback;
+        EventQueue eventQueue;
     } data_;
 
     GLFWwindow* window_;
@@ -0,0 +1,169 @@
+import struct
+import sys
+
+# Converts a Wavefront OBJ file into the binary .emesh container that
+# ember::LlyModel::createFromFile maps and uploads without parsing. The
+# layout written here has to match emberlily/src/Vulkan/LlyMeshFormat.hpp.
+#
+# The engine's vertex is a 2D position and a color, so z is dropped. Colors
+# come from the "v x y z r g b" extension some exporters write, white when
+# missing. Faces are triangulated as fans, identical vertices are shared
+# through the index buffer, indices are 16 bit when they fit.
+#
+# --format picks the vertex layout (ember::VertexFormat): float is 20 bytes
+# per vertex, half and snorm16 store the position in 16 bit components and
+# the color as RGBA8, 8 bytes. snorm16 positions are relative to the mesh
+# bounds, the header says how to map them back.
+#
+# Usage: python tools/convert_mesh.py [--format float|half|snorm16] model.obj model.emesh
+
+MAGIC = b'EMSH'
+VERSION = 2
+ALIGNMENT = 64
+MAX_ATTRIBUTES = 8
+
+# VkFormat values
+R8G8B8A8_UNORM = 37
+R16G16_SNORM = 78
+R16G16_SFLOAT = 83
+R32G32_SFLOAT = 103
+R32G32B32_SFLOAT = 106
+
+# Vertex struct and attributes per format, as in LlyVertexFormat.cpp
+FORMATS = {
+    'float': (struct.Struct('<5f'), [(0, R32G32_SFLOAT, 0), (1, R32G32B32_SFLOAT, 8)]),
+    'half': (struct.Struct('<2e4B'), [(0, R16G16_SFLOAT, 0), (1, R8G8B8A8_UNORM, 4)]),
+    'snorm16': (struct.Struct('<2h4B'), [(0, R16G16_SNORM, 0), (1, R8G8B8A8_UNORM, 4)]),
+}
+
+HEADER = struct.Struct('<4s7I2Q')
+ATTRIBUTE = struct.Struct('<3I')
+DECODE = struct.Struct('<4f')
+HEADER_SIZE = HEADER.size + ATTRIBUTE.size * MAX_ATTRIBUTES + DECODE.size
+
+
+def align(offset):
+    return (offset + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+
+def clamp(value, low, high):
+    return min(max(value, low), high)
+
+
+def unorm8(value):
+    return int(round(clamp(value, 0.0, 1.0) * 255.0))
+
+
+def encode_vertices(vertices, format):
+    """Returns the packed vertex bytes and the position scale and offset."""
+    vertex, _ = FORMATS[format]
+    scale, offset = (1.0, 1.0), (0.0, 0.0)
+
+    if format == 'float':
+        return b''.join(vertex.pack(*v) for v in vertices), scale, offset
+
+    if format == 'snorm16':
+        low = [min(v[axis] for v in vertices) for axis in range(2)]
+        high = [max(v[axis] for v in vertices) for axis in range(2)]
+        # Rounded to what the header stores, so encoding and decoding agree
+        offset = tuple(struct.unpack('<f', struct.pack('<f', (low[a] + high[a]) * 0.5))[0] for a in range(2))
+        scale = tuple(struct.unpack('<f', struct.pack('<f', (high[a] - low[a]) * 0.5 or 1.0))[0] for a in range(2))
+
+    packed = []
+    for v in vertices:
+        if format == 'half':
+            try:
+                position = (v[0], v[1])
+                struct.pack('<2e', *position)
+            except OverflowError:
+                raise SystemExit('vertex {} is out of half float range, use snorm16'.format(v[:2]))
+        else:
+            position = tuple(int(round(clamp((v[a] - offset[a]) / scale[a], -1.0, 1.0) * 32767.0)) for a in range(2))
+        color = (unorm8(v[2]), unorm8(v[3]), unorm8(v[4]), 255)
+        packed.append(vertex.pack(*(position + color)))
+    return b''.join(packed), scale, offset
+
+
+def read_obj(path):
+    positions = []
+    vertices = []
+    lookup = {}
+    indices = []
+
+    with open(path, 'r') as file:
+        for number, line in enumerate(file, 1):
+            fields = line.split()
+            if not fields:
+                continue
+
+            if fields[0] == 'v':
+                values = [float(value) for value in fields[1:]]
+                if len(values) < 2:
+                    raise SystemExit('{}:{}: vertex needs at least x and y'.format(path, number))
+                color = tuple(values[3:6]) if len(values) >= 6 else (1.0, 1.0, 1.0)
+                positions.append((values[0], values[1]) + color)
+
+            elif fields[0] == 'f':
+                corners = []
+                for corner in fields[1:]:
+                    index = int(corner.split('/')[0])
+                    # Negative indices count back from the last vertex
+                    index = index - 1 if index > 0 else len(positions) + index
+                    if index < 0 or index >= len(positions):
+                        raise SystemExit('{}:{}: face refers to a missing vertex'.format(path, number))
+
+                    vertex = positions[index]
+                    if vertex not in lookup:
+                        lookup[vertex] = len(vertices)
+                        vertices.append(vertex)
+                    corners.append(lookup[vertex])
+
+                for i in range(1, len(corners) - 1):
+                    indices += [corners[0], corners[i], corners[i + 1]]
+
+    if len(indices) < 3:
+        raise SystemExit(path + ' has no faces')
+    return vertices, indices
+
+
+def write_mesh(path, vertices, indices, format):
+    vertex, attributes = FORMATS[format]
+    vertex_bytes, scale, offset = encode_vertices(vertices, format)
+
+    index_size = 2 if len(vertices) <= 0xFFFF else 4
+    vertex_offset = align(HEADER_SIZE)
+    index_offset = align(vertex_offset + len(vertex_bytes))
+
+    header = HEADER.pack(
+        MAGIC, VERSION, len(vertices), len(indices), vertex.size, index_size, len(attributes), 0,
+        vertex_offset, index_offset)
+    header += b''.join(ATTRIBUTE.pack(*attribute) for attribute in attributes)
+    header += b''.join(ATTRIBUTE.pack(0, 0, 0) for _ in range(MAX_ATTRIBUTES - len(attributes)))
+    header += DECODE.pack(scale[0], scale[1], offset[0], offset[1])
+
+    with open(path, 'wb') as file:
+        file.write(header)
+        file.write(b'\0' * (vertex_offset - HEADER_SIZE))
+        file.write(vertex_bytes)
+        file.write(b'\0' * (index_offset - vertex_offset - len(vertex_bytes)))
+        file.write(struct.pack('<{}{}'.format(len(indices), 'H' if index_size == 2 else 'I'), *indices))
+
+    print('{}: {} vertices ({}, {} bytes each), {} indices ({} bit)'.format(
+        path, len(vertices), format, vertex.size, len(indices), index_size * 8))
+
+
+def main():
+    arguments = sys.argv[1:]
+    format = 'float'
+    if len(arguments) == 4 and arguments[0] == '--format' and arguments[1] in FORMATS:
+        format = arguments[1]
+        arguments = arguments[2:]
+    if len(arguments) != 2:
+        raise SystemExit('Usage: convert_mesh.py [--format float|half|snorm16] <model.obj> <model.emesh>')
+
+    vertices, indices = read_obj(arguments[0])
+    write_mesh(arguments[1], vertices, indices, format)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,93 @@
+import re
+import struct
+import sys
+
+# Decodes the binary file written by ember::FlightRecorder::Dump into text,
+# one line per record ordered by time across all threads.
+#
+# Usage: python tools/decode_flight_record.py flight_record.bin
+
+RECORD = struct.Struct('<QII3Q')
+PLACEHOLDER = re.compile(r'\{(\d)\}')
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def read(self, fmt):
+        values = struct.unpack_from(fmt, self.data, self.offset)
+        self.offset += struct.calcsize(fmt)
+        return values
+
+    def u32(self):
+        return self.read('<I')[0]
+
+    def string(self):
+        length = self.u32()
+        text = self.data[self.offset:self.offset + length].decode('utf-8', 'replace')
+        self.offset += length
+        return text
+
+
+def decode(path):
+    with open(path, 'rb') as file:
+        reader = Reader(file.read())
+
+    magic = reader.read('<4s')[0]
+    if magic != b'EMFR':
+        raise SystemExit(path + ' is not a flight recorder dump')
+
+    version = reader.u32()
+    if version != 1:
+        raise SystemExit('Unsupported dump version ' + str(version))
+
+    ticks_per_second = reader.read('<d')[0]
+
+    formats = []
+    for _ in range(reader.u32()):
+        line = reader.u32()
+        source = reader.string()
+        text = reader.string()
+        formats.append((source, line, text))
+
+    records = []
+    for _ in range(reader.u32()):
+        thread = reader.u32()
+        for _ in range(reader.u32()):
+            ticks, format_id, arg_count, *args = reader.read(RECORD.format)
+            # Arguments are stored as 64 bit words, show negative values
+            # (e.g. VkResult errors) as such
+            args = [arg - (1 << 64) if arg >= (1 << 63) else arg for arg in args[:arg_count]]
+            records.append((ticks, thread, format_id, args))
+
+    if not records:
+        print('No records')
+        return
+
+    records.sort()
+    start = records[0][0]
+
+    for ticks, thread, format_id, args in records:
+        milliseconds = (ticks - start) * 1000.0 / ticks_per_second
+        if format_id < len(formats):
+            source, line, text = formats[format_id]
+            message = PLACEHOLDER.sub(lambda m: str(args[int(m.group(1))]) if int(m.group(1)) < len(args) else m.group(0), text)
+            location = source.replace('\\', '/').split('/')[-1] + ':' + str(line)
+        else:
+            message = 'unknown format ' + str(format_id) + ' ' + str(args)
+            location = '?'
+
+        print('{:12.3f} ms  [thread {}]  {}  ({})'.format(milliseconds, thread, message, location))
+
+
+def main():
+    if len(sys.argv) != 2:
+        raise SystemExit('Usage: decode_flight_record.py <dump file>')
+
+    decode(sys.argv[1])
+
+
+if __name__ == "__main__":
+    main()